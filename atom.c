@@ -3,6 +3,9 @@
 
 #include "vasm.h"
 
+unsigned long atoms_added;  /* to any section */
+static atom *last_merged;
+
 
 /* searches mnemonic list and tries to parse (via the cpu module)
    the operands according to the mnemonic requirements; returns an
@@ -32,6 +35,7 @@ instruction *new_inst(const char *inst,int len,
     do {
       inst_found = 1;
       mnemo = &mnemonics[i];
+      hot_stats[HS_MNEMO_TRIALS]++;
 
       if (!MNEMONIC_VALID(i)) {
         i++;
@@ -252,7 +256,10 @@ static size_t roffs_size(reloffs *roffs,section *sec,taddr pc)
 
 static void internal_add_atom(section *sec,atom *a)
 {
+  atoms_added++;
+  last_merged = NULL;  /* add_merged_data() may only append to its own atom */
   a->changes = 0;
+  a->resizes = 0;
   a->src = cur_src;
   a->line = cur_src!=NULL ? cur_src->line : 0;
 
@@ -313,6 +320,83 @@ void add_or_save_atom(atom *a)
 }
 
 
+/* Adds a dblock without relocations to the current section. It is appended
+   to the previous DATA atom created here, as long as nothing else was added
+   in between and no listing is generated, which wants its atoms per value.
+   Tables of constants then need a single atom instead of one per value.
+   The dblock is consumed. */
+void add_merged_data(dblock *db)
+{
+  static size_t last_cap;
+  section *sec;
+
+  if (!(sec = default_section())) {
+    general_error(3);
+    return;
+  }
+
+  if (sec->last!=NULL && sec->last==last_merged &&
+      db->relocs==NULL && !listena) {
+    dblock *ldb = last_merged->content.db;
+
+    if (ldb->size+db->size > last_cap) {
+      last_cap = (ldb->size+db->size) * 2;
+      ldb->data = myrealloc(ldb->data,last_cap);
+    }
+    memcpy(ldb->data+ldb->size,db->data,db->size);
+    ldb->size += db->size;
+    last_merged->lastsize += db->size;
+    sec->pc += db->size;
+    myfree(db->data);
+    myfree(db);
+  }
+  else {
+    atom *a = new_data_atom(db,1);
+
+    add_atom(sec,a);
+    last_merged = db->relocs==NULL ? a : NULL;
+    last_cap = db->size;
+  }
+}
+
+
+/* the next add_merged_data() starts a new atom */
+void end_merged_data(void)
+{
+  last_merged = NULL;
+}
+
+
+/* Adds a byte-aligned data definition to the current section. Plain 8- and
+   16-bit numbers are evaluated at once and merged with their neighbours
+   by add_merged_data(), except in a structure definition, where every
+   value has to remain a field of its own. This requires a cpu module which
+   keeps the whole operand in a single expression. */
+void add_datadef(size_t bitsize,operand *op)
+{
+  atom *a;
+#if defined(VASM_CPU_650X) || defined(VASM_CPU_Z80) || \
+    defined(VASM_CPU_6800) || defined(VASM_CPU_6809)
+  section *sec;
+  taddr val;
+
+  if (op->value->type==NUM && (bitsize==8 || bitsize==16) &&
+      (sec = default_section())!=NULL && !(sec->flags & LABELS_ARE_LOCAL)) {
+    val = op->value->c.val;
+    if (val>=-(1L<<(bitsize-1)) && val<(1L<<bitsize)) {
+      add_merged_data(eval_data(op,bitsize,sec,sec->pc));
+      free_expr(op->value);
+      myfree(op);
+      return;
+    }
+  }
+#endif
+  a = new_datadef_atom(bitsize,op);
+  a->align = 1;
+  add_atom(0,a);
+}
+
+
 size_t atom_size(atom *p,section *sec,taddr pc)
 {
   switch(p->type) {
@@ -533,6 +617,79 @@ atom *clone_atom(atom *a)
 }
 
 
+/* Check whether replicate_atom() can copy an atom of this kind. The copy
+   of an instruction or a data definition shares the operands and their
+   expressions with the original. A cpu module defines REPLICATE_OPERANDS
+   in cpu.h, when it never modifies or frees them after parsing. */
+int replicable_atom(atom *a)
+{
+  switch (a->type) {
+    case DATA:
+      return a->content.db->relocs == NULL;
+    case SPACE:
+      return a->content.sb->relocs == NULL;
+    case INSTRUCTION:
+    case DATADEF:
+      return REPLICATE_OPERANDS;
+  }
+  return 0;
+}
+
+
+/* Make a copy of an atom from the parser, which is assembled independently
+   of the original, so nothing but the expressions is shared. Source and
+   line are kept, the listing is not. */
+atom *replicate_atom(atom *a)
+{
+  atom *new = mymalloc(sizeof(atom));
+#if MAX_OPERANDS!=0
+  int i;
+#endif
+
+  memcpy(new,a,sizeof(atom));
+
+  switch (a->type) {
+    case DATA:
+      new->content.db = new_dblock();
+      new->content.db->size = a->content.db->size;
+      new->content.db->data = mymalloc(OCTETS(a->content.db->size));
+      memcpy(new->content.db->data,a->content.db->data,
+             OCTETS(a->content.db->size));
+      break;
+    case SPACE:
+      new->content.sb = mymalloc(sizeof(sblock));
+      memcpy(new->content.sb,a->content.sb,sizeof(sblock));
+      break;
+    case INSTRUCTION:
+      new->content.inst = mymalloc(sizeof(instruction));
+      memcpy(new->content.inst,a->content.inst,sizeof(instruction));
+#if MAX_OPERANDS!=0
+      for (i=0; i<MAX_OPERANDS; i++) {
+        if (a->content.inst->op[i] != NULL) {
+          new->content.inst->op[i] = mymalloc(sizeof(operand));
+          memcpy(new->content.inst->op[i],a->content.inst->op[i],
+                 sizeof(operand));
+        }
+      }
+#endif
+      break;
+    case DATADEF:
+      new->content.defb = mymalloc(sizeof(defblock));
+      new->content.defb->bitsize = a->content.defb->bitsize;
+      new->content.defb->op = mymalloc(sizeof(operand));
+      memcpy(new->content.defb->op,a->content.defb->op,sizeof(operand));
+      break;
+    default:
+      ierror(0);
+      break;
+  }
+
+  new->next = 0;
+  new->list = NULL;
+  return new;
+}
+
+
 atom *add_data_atom(section *sec,size_t sz,taddr alignment,taddr c)
 {
   dblock *db = new_dblock();
@@ -85,6 +85,7 @@ struct atom {
   taddr align;
   size_t lastsize;
   unsigned changes;
+  unsigned resizes;            /* all size modifications, for -resolve-stats */
   source *src;
   int line;
   listing *list;
@@ -110,6 +111,8 @@ struct atom {
 enum {
   PO_CORRUPT=-1,PO_NOMATCH=0,PO_MATCH,PO_SKIP,PO_COMB_OPT,PO_COMB_REQ,PO_NEXT
 };
+extern unsigned long atoms_added;
+
 instruction *new_inst(const char *,int,int,char **,int *);
 instruction *copy_inst(instruction *);
 dblock *new_dblock(void);
@@ -118,10 +121,15 @@ sblock *new_sblock(expr *,size_t,expr *);
 atom *new_atom(int,taddr);
 void add_atom(section *,atom *);
 void add_or_save_atom(atom *);
+void add_merged_data(dblock *);
+void end_merged_data(void);
+void add_datadef(size_t,operand *);
 size_t atom_size(atom *,section *,taddr);
 void print_atom(FILE *,atom *);
 void atom_printexpr(printexpr *,section *,taddr);
 atom *clone_atom(atom *);
+int replicable_atom(atom *);
+atom *replicate_atom(atom *);
 
 /* this group is currently used by dwarf.c only */
 atom *add_data_atom(section *,size_t,taddr,taddr);
@@ -6,7 +6,7 @@
 int clev;  /* conditional level */
 
 static signed char cond[MAXCONDLEV+1];
-static char *condsrc[MAXCONDLEV+1];
+static const char *condsrc[MAXCONDLEV+1];
 static int condline[MAXCONDLEV+1];
 static int ifnesting;
 
@@ -485,7 +485,7 @@ char *parse_cpu_special(char *start)
 }
 
 
-int parse_cpu_label(char *labname,char **start)
+int parse_cpu_label(const char *labname,char **start)
 /* parse cpu-specific directives following a label field,
    return zero when no valid directive was recognized */
 {
@@ -1182,6 +1182,7 @@ int init_cpu(void)
   }
 
   cpudirhash = new_hashtable(0x100);
+  cpudirhash->name = "cpu directives";
   for (i=0; i<sizeof(cpudirs)/sizeof(cpudirs[0]); i++) {
     data.idx = i;
     add_hashentry(cpudirhash,cpudirs[i].name,data,1);  /* case insensitive */
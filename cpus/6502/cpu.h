@@ -29,6 +29,8 @@ typedef struct {
 /* minimum instruction alignment */
 #define INST_ALIGN 1
 
+#define REPLICATE_OPERANDS 1
+
 /* default alignment for n-bit data */
 #define DATA_ALIGN(n) 1
 
@@ -146,7 +148,7 @@ extern uint16_t cpu_type;
 /* Syntax-module configurable flags */
 extern int allow_trailing_comments;  /* Allow informal comments after operands (Merlin compatibility) */
 int cpu_available(int);
-int parse_cpu_label(char *,char **);
+int parse_cpu_label(const char *,char **);
 int set_cpu_type(const char *);
 void set_65816_sizes(int a_size, int x_size);
 void get_65816_sizes(int *a_size, int *x_size);
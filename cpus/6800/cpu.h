@@ -22,6 +22,8 @@ typedef uint16_t utaddr;
 /* minimum instruction alignment */
 #define INST_ALIGN 1
 
+#define REPLICATE_OPERANDS 1
+
 /* default alignment for n-bit data */
 #define DATA_ALIGN(n) 1
 
@@ -133,6 +133,7 @@ void init_instruction_ext(instruction_ext *ext)
 {
   ext->ocidx = OCSTD;
   ext->dp = dpage;  /* current DP defined by SETDP directive */
+  ext->size = 0;
 }
 
 
@@ -1057,9 +1058,93 @@ static size_t process_instruction(instruction *ip,section *sec,
 }
 
 
+static int pc_dependent(instruction *ip)
+/* returns true when the instruction size may depend on its PC */
+{
+  operand *op;
+  int i;
+
+  if (opt_pc || (opt_bra && *mnemonics[ip->code].name=='j'))
+    return 1;  /* EXT may be optimized to PC-relative modes */
+
+  for (i=0; i<MAX_OPERANDS; i++) {
+    if ((op = ip->op[i]) == NULL)
+      break;
+    switch (op->mode) {
+      case AM_REL8:
+      case AM_REL9:
+      case AM_REL16:
+        return 1;
+      case AM_COFFS:
+        if (op->opreg>=0 && registers[op->opreg].value==REG_PC)
+          return 1;
+        break;
+    }
+  }
+  return 0;
+}
+
+
+static uint8_t value_class(instruction *ip,operand *op,section *sec,taddr pc)
+/* Classify an operand value by everything which may affect the size
+   of a PC-independent instruction: relocatable, direct page and the
+   constant offset ranges of the indexed addressing modes. */
+{
+  taddr val;
+  uint8_t vc;
+
+  if (op->value == NULL)
+    return 0;
+  if (!eval_expr(op->value,&val,sec,pc))
+    return 1;
+
+  if ((utaddr)val>=(ip->ext.dp<<8) && (utaddr)val<=(ip->ext.dp<<8)+0xff)
+    vc = 0x10;
+  else
+    vc = 0;
+  val = bf_sign_extend(val,16);
+  if (val == 0)
+    vc |= 2;
+  else if (val>=-16 && val<=15)
+    vc |= 3;
+  else if (val>=-128 && val<=127)
+    vc |= 4;
+  else if (val>=-256 && val<=255)
+    vc |= 5;
+  else
+    vc |= 6;
+  return vc;
+}
+
+
 size_t instruction_size(instruction *ip,section *sec,taddr pc)
 {
-  return process_instruction(copy_inst(ip),sec,pc,0);
+  uint8_t vc[MAX_OPERANDS];
+  size_t size;
+  int i,n;
+
+  if (pc_dependent(ip))
+    return process_instruction(copy_inst(ip),sec,pc,0);
+
+  /* The indexed mode, offset size and DIR/EXT selection only change
+     with the class of the operand values, so reuse the last size when
+     no class changed since the previous pass. */
+  for (n=0; n<MAX_OPERANDS && ip->op[n]!=NULL; n++)
+    vc[n] = value_class(ip,ip->op[n],sec,pc);
+  if (ip->ext.size != 0) {
+    for (i=0; i<n; i++) {
+      if (vc[i] != ip->ext.vclass[i])
+        break;
+    }
+    if (i == n)
+      return ip->ext.size;
+  }
+
+  size = process_instruction(copy_inst(ip),sec,pc,0);
+  for (i=0; i<n; i++)
+    ip->ext.vclass[i] = vc[i];
+  ip->ext.size = (uint8_t)size;
+  return size;
 }
 
 
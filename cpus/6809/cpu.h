@@ -27,6 +27,8 @@ typedef uint32_t utaddr;
 typedef struct {
   uint8_t ocidx; /* opcode index STD,DIR,IDX,EXT */
   uint8_t dp;    /* remember current direct page per instruction */
+  uint8_t size;  /* size from last pass, 0 when not cached */
+  uint8_t vclass[MAX_OPERANDS];  /* operand value classes of size */
 } instruction_ext;
 
 /* minimum instruction alignment */
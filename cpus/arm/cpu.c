@@ -698,7 +698,7 @@ static void create_mapping_symbol(int type,section *sec,taddr pc)
     sym = mymalloc(sizeof(symbol));
     sym->type = LABSYM;
     sym->flags = types[type];
-    sym->name = names[type];
+    sym->name = intern_name(names[type]);
     sym->sec = sec;
     sym->pc = pc;
     sym->expr = 0;
@@ -689,6 +689,7 @@ int init_cpu(void)
       JNBS=i;
   }
   sfrhash=new_hashtable(SFRHTSIZE);
+  sfrhash->name="SFRs";
   return 1;
 }
 
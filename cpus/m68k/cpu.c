@@ -5663,7 +5663,9 @@ int init_cpu(void)
 
   /* build hash table for special register names */
   spechash = new_hashtable(0x1000);
+  spechash->name = "special registers";
   movchash = new_hashtable(0x800);
+  movchash->name = "movec registers";
   for (i=0; i<specreg_cnt; i++) {
     data.idx = i;
     add_hashentry(i<FIRST_CTRLREG?spechash:movchash,SpecRegs[i].name,data,1);
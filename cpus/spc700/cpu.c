@@ -834,6 +834,7 @@ int init_cpu(void)
   }
 
   cpudirhash = new_hashtable(0x100);
+  cpudirhash->name = "cpu directives";
   for (i=0; i<sizeof(cpudirs)/sizeof(cpudirs[0]); i++) {
     data.idx = i;
     add_hashentry(cpudirhash,cpudirs[i].name,data,1);  /* case insensitive */
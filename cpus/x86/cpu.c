@@ -65,6 +65,13 @@ static const char *operand_type_str[] = {
 /* scale factors log2(scale) -> original scale factor */
 static const int scale_factor_tab[4] = { 1, 2, 4, 8 };
 
+/* index of the first mnemonic behind the group of equally named ones */
+static int *mnemo_group_end;
+
+/* operand value classes, used to validate a cached instruction size */
+#define VCLASS_NONE       0             /* operand has no value */
+#define VCLASS_RELOC      (Imm8|Imm16|Imm32|Imm64)  /* unknown or reloc */
+
 
 
 void cpu_opts(void *opts,section *sec)
@@ -539,8 +546,8 @@ static int find_next_mnemonic(instruction *ip)
 /* finds a mnemonic with the same name, which fits the given
    operand types and suffix */
 {
-  const char *inst_name = mnemonics[ip->code].name;
   int code = ip->code + 1;
+  int end = mnemo_group_end[ip->code];
   mnemonic *mnemo = &mnemonics[code];
   uint32_t chksuffix = suffix_flag(ip);
 
@@ -550,7 +557,7 @@ static int find_next_mnemonic(instruction *ip)
     print_operands(ip,-1);
   }
 
-  while (!strcmp(inst_name,mnemo->name)) {
+  while (code < end) {
     int i,given,allowed,overlap,new_types[MAX_OPERANDS];
 
     for (i=0; i<MAX_OPERANDS; i++) {
@@ -656,35 +663,45 @@ static int fix_imm_size(instruction *ip,operand *op,int final)
 }
 
 
-static void optimize_imm(instruction *ip,operand *op,section *sec,
-                         taddr pc,int final)
-/* determine smallest type which can hold the immediate mode */
+static int value_types(expr *exp,section *sec,taddr pc)
+/* return the immediate types which are able to hold the expression's value,
+   VCLASS_RELOC when it is not constant yet */
 {
   taddr val;
-  int ot,nt;
+  int ot;
 
-  if (!eval_expr(op->value,&val,sec,pc)) {
+  if (!eval_expr(exp,&val,sec,pc)) {
     /* reloc or unknown symbols have always full size until they are known */
-    ot = Imm8|Imm16|Imm32|Imm64;  /* @@@ FIXME */
-  }
-  else {
-    /* set valid operand types for this number */
-    ot = Imm64;
-    if (val>=-0x80000000LL && val<=0xffffffffLL) {
-      ot |= Imm32;
-      if (val<=0x7fffffffLL) {
-        ot |= Imm32S;
-        if (val>=-0x8000 && val<=0xffff) {
-          ot |= Imm16;
-          if (val>=-0x80 && val<=0xff) {
-            ot |= Imm8;
-            if (val<=0x7f)
-              ot |= Imm8S;
-          }
+    return VCLASS_RELOC;  /* @@@ FIXME */
+  }
+
+  /* set valid operand types for this number */
+  ot = Imm64;
+  if (val>=-0x80000000LL && val<=0xffffffffLL) {
+    ot |= Imm32;
+    if (val<=0x7fffffffLL) {
+      ot |= Imm32S;
+      if (val>=-0x8000 && val<=0xffff) {
+        ot |= Imm16;
+        if (val>=-0x80 && val<=0xff) {
+          ot |= Imm8;
+          if (val<=0x7f)
+            ot |= Imm8S;
         }
       }
     }
   }
+  return ot;
+}
+
+
+static void optimize_imm(instruction *ip,operand *op,section *sec,
+                         taddr pc,int final)
+/* determine smallest type which can hold the immediate mode */
+{
+  int ot,nt;
+
+  ot = value_types(op->value,sec,pc);
   nt = ot & fix_imm_size(ip,op,final);
 
   while (!nt) {
@@ -1804,6 +1821,31 @@ size_t instruction_size(instruction *realip,section *sec,taddr pc)
     }
   }
 
+  /* The size of a non-jump instruction only depends on the value classes
+     of its operands (reloc, 8, 16, 32 or 64 bits), so reuse the last
+     size when none of them changed. Only jumps have to be relaxed. */
+  if (!(mnemonics[realip->code].ext.opcode_modifier&(Jmp|JmpByte|JmpDword))) {
+    int cls[MAX_OPERANDS];
+
+    for (i=0; i<MAX_OPERANDS; i++) {
+      if (realip->op[i]!=NULL && realip->op[i]->value!=NULL)
+        cls[i] = value_types(realip->op[i]->value,sec,pc);
+      else
+        cls[i] = VCLASS_NONE;
+    }
+    if (realip->ext.flags & SIZE_CACHED) {
+      for (i=0; i<MAX_OPERANDS; i++) {
+        if (cls[i] != realip->ext.opclass[i])
+          break;
+      }
+      if (i == MAX_OPERANDS)
+        return (size_t)realip->ext.last_size;
+    }
+    for (i=0; i<MAX_OPERANDS; i++)
+      realip->ext.opclass[i] = cls[i];
+    realip->ext.flags |= SIZE_CACHED;
+  }
+
   /* work on a copy of the current instruction and finalize it */
   size = finalize_instruction(copy_inst(realip),sec,pc,0);
 
@@ -1904,12 +1946,21 @@ dblock *eval_data(operand *op,size_t bitsize,section *sec,taddr pc)
 
 int init_cpu(void)
 {
-  int i;
+  int i,j;
   regsym *r;
 
   if (!(cpu_type & CPU64))
     cpu_type |= CPUNo64;
 
+  /* precompute the end of each group of mnemonics with the same name */
+  mnemo_group_end = mymalloc(mnemonic_cnt*sizeof(int));
+  for (i=0; i<mnemonic_cnt; i=j) {
+    for (j=i+1; j<mnemonic_cnt && !strcmp(mnemonics[i].name,mnemonics[j].name);
+         j++);
+    while (i < j)
+      mnemo_group_end[i++] = j;
+  }
+
   for (i=0; i<mnemonic_cnt; i++) {
     if (!strcmp(mnemonics[i].name,"addr16"))
       OC_ADDR_PREFIX = (unsigned char)mnemonics[i].ext.base_opcode;
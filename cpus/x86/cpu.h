@@ -206,6 +206,7 @@ typedef struct {
   modrm_byte rm;
   sib_byte sib;
   short last_size;
+  int opclass[MAX_OPERANDS];    /* operand value classes of last_size */
 } instruction_ext;
 
 /* flags: */
@@ -213,6 +214,7 @@ typedef struct {
 #define SUFFIX_CHECKED    0x2   /* suffix assigned and checked */
 #define MODRM_BYTE        0x4   /* needs mod/rm byte */
 #define SIB_BYTE          0x8   /* needs sib byte */
+#define SIZE_CACHED       0x10  /* last_size is valid for opclass[] */
 #define NEGOPT            0x40  /* negatively optimized, bytes gained */
 #define POSOPT            0x80  /* positively optimized, bytes gained */
 #define OPTFAILED         (POSOPT|NEGOPT)  /* no longer try to optimize this */
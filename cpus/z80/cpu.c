@@ -727,6 +727,12 @@ static int ioi_enabled = 0;
 static int ioe_enabled = 0;
 static int modifier;  /* set by find_base() */
 
+/* register and flag names, hashed by init_cpu() */
+#define REGHTSIZE 0x100
+#define FLAGHTSIZE 0x40
+static hashtable *reghash;
+static hashtable *flaghash;
+
 
 struct {
     char         *name;
@@ -854,23 +860,13 @@ int ext_find_base(symbol **base,expr *p,section *sec,taddr pc)
 
 static int get_flags_info(char **text, int len, int *flags_ptr, int *op)
 {
-    int     i;
+    hashdata data;
 
-    for ( i = 0; i < sizeof(flags) / sizeof(flags[0]); i++ ) {
-        if ( len != strlen(flags[i].name) ) {
-            continue;
-        }
-        if ( strnicmp(*text, flags[i].name,len) == 0 ) {            
-#if 0
-            if ( (cpu_type & flags[i].cpu) == 0 ) {
-                continue;
-            }
-#endif
-            *text += len;
-            *op= flags[i].op;
-            *flags_ptr = flags[i].flags;
-            return 0;
-        }
+    if ( find_namelen_nc(flaghash, *text, len, &data) ) {
+        *text += len;
+        *op = flags[data.idx].op;
+        *flags_ptr = flags[data.idx].flags;
+        return 0;
     }
     return -1;
 }
@@ -879,23 +875,13 @@ static int get_flags_info(char **text, int len, int *flags_ptr, int *op)
 
 static int get_register_info(char **text, int len, int *reg, int *op)
 {
-    int     i;
+    hashdata data;
 
-    for ( i = 0; i < sizeof(registers) / sizeof(registers[0]); i++ ) {
-        if ( len != strlen(registers[i].name) ) {
-            continue;
-        }
-        if ( strnicmp(*text, registers[i].name,len) == 0 ) {
-#if 0
-            if ( (cpu_type & registers[i].cpu) == 0 ) {
-                continue;
-            }
-#endif
-            *text += len;
-            *reg = registers[i].reg;
-            *op = registers[i].op;
-            return 0;
-        }
+    if ( find_namelen_nc(reghash, *text, len, &data) ) {
+        *text += len;
+        *reg = registers[data.idx].reg;
+        *op = registers[data.idx].op;
+        return 0;
     }
     return -1;
 }
@@ -1288,6 +1274,7 @@ void init_instruction_ext(instruction_ext *ext)
     ext->altd = altd_enabled;
     ext->ioi = ioi_enabled;
     ext->ioe = ioe_enabled;
+    ext->size = 0;
 }
 
 static int parse_rcm_identifier(char **sptr)
@@ -1384,7 +1371,7 @@ char *parse_cpu_special(char *start)
     return start;
 }
 
-size_t instruction_size(instruction *ip, section *sec, taddr pc)
+static size_t calc_instruction_size(instruction *ip)
 {
     mnemonic *opcode = &mnemonics[ip->code];
     size_t    size;
@@ -1498,6 +1485,18 @@ size_t instruction_size(instruction *ip, section *sec, taddr pc)
 }
 
 
+size_t instruction_size(instruction *ip, section *sec, taddr pc)
+{
+    /* The size only depends on the opcode and the operand types, which
+     * are known after parsing, so it has to be determined only once.
+     */
+    if ( ip->ext.size == 0 ) {
+        ip->ext.size = (int)calc_instruction_size(ip);
+    }
+    return (size_t)ip->ext.size;
+}
+
+
 
 static taddr apply_modifier(rlist *rl, taddr val)
 {
@@ -2234,7 +2233,25 @@ operand *new_operand(void)
 
 int init_cpu(void)
 {
+  hashdata data;
+  int i;
+
   current_pc_char = '$';
+
+  /* hash register and flag names once, instead of comparing each
+     operand against all of them */
+  reghash = new_hashtable(REGHTSIZE);
+  reghash->name = "registers";
+  for (i=0; i<sizeof(registers)/sizeof(registers[0]); i++) {
+    data.idx = i;
+    add_hashentry(reghash,registers[i].name,data,1);
+  }
+  flaghash = new_hashtable(FLAGHTSIZE);
+  flaghash->name = "flags";
+  for (i=0; i<sizeof(flags)/sizeof(flags[0]); i++) {
+    data.idx = i;
+    add_hashentry(flaghash,flags[i].name,data,1);
+  }
   return 1;
 }
 
@@ -47,11 +47,14 @@ typedef struct {
     int  altd;
     int  ioi;
     int  ioe;
+    int  size;   /* cached by instruction_size(), 0 when unknown */
 } instruction_ext;
 
 /* minimum instruction alignment */
 #define INST_ALIGN 1
 
+#define REPLICATE_OPERANDS 1
+
 /* default alignment for n-bit data */
 #define DATA_ALIGN(n) 1
 
@@ -17,6 +17,8 @@ struct DWfile {
 };
 
 
+#define LBUFINC 0x400  /* initial size of the line program buffer */
+
 static const unsigned char stdopclengths[] = {
   0,1,1,1,1,0,0,0,1
 };
@@ -168,6 +170,9 @@ void dwarf_init(struct dwarf_info *dinfo,
   dinfo->line_range = 16;
   dinfo->opcode_base = sizeof(stdopclengths) + 1;
   dinfo->max_pcadvance = (255 - dinfo->opcode_base) / dinfo->line_range;
+  dinfo->lbuf = NULL;
+  dinfo->llen = dinfo->lsize = 0;
+  dinfo->lrelocs = NULL;
 
   dinfo->asec = dsec = new_section(".debug_aranges","r",1);
 
@@ -299,8 +304,87 @@ void dwarf_init(struct dwarf_info *dinfo,
 }
 
 
+/* The statement program of a sequence is collected in a buffer and
+   becomes a single DATA atom in .debug_line, when the sequence ends. */
+
+static uint8_t *lbuf_room(struct dwarf_info *dinfo,size_t n)
+{
+  uint8_t *p;
+
+  if (dinfo->llen + n > dinfo->lsize) {
+    do
+      dinfo->lsize = dinfo->lsize ? dinfo->lsize*2 : LBUFINC;
+    while (dinfo->llen + n > dinfo->lsize);
+    dinfo->lbuf = myrealloc(dinfo->lbuf,OCTETS(dinfo->lsize));
+  }
+  p = dinfo->lbuf + OCTETS(dinfo->llen);
+  dinfo->llen += n;
+  return p;
+}
+
+
+static void lbuf_byte(struct dwarf_info *dinfo,taddr b)
+{
+  writebyte(lbuf_room(dinfo,1),b);
+}
+
+
+static void lbuf_leb128(struct dwarf_info *dinfo,utaddr c)
+{
+  taddr b;
+
+  do {
+    b = c & 0x7f;
+    if ((c >>= 7) != 0)
+      b |= 0x80;
+    lbuf_byte(dinfo,b);
+  } while (c != 0);
+}
+
+
+static void lbuf_sleb128(struct dwarf_info *dinfo,taddr c)
+{
+  int done = 0;
+  taddr b;
+
+  do {
+    b = c & 0x7f;
+    c >>= 7;  /* assumes arithmetic shifts! */
+    if ((c==0 && !(b&0x40)) || (c==-1 && (b&0x40)))
+      done = 1;
+    else
+      b |= 0x80;
+    lbuf_byte(dinfo,b);
+  } while (!done);
+}
+
+
+static void lbuf_flush(struct dwarf_info *dinfo)
+{
+  dblock *db;
+  rlist *rl;
+
+  if (dinfo->llen) {
+    db = new_dblock();
+    db->size = dinfo->llen;
+    db->data = myrealloc(dinfo->lbuf,OCTETS(dinfo->llen));
+    /* relocations were prepended, restore their ascending order */
+    while (rl = dinfo->lrelocs) {
+      dinfo->lrelocs = rl->next;
+      rl->next = db->relocs;
+      db->relocs = rl;
+    }
+    add_atom(dinfo->lsec,new_data_atom(db,1));
+    dinfo->lbuf = NULL;
+    dinfo->llen = dinfo->lsize = 0;
+  }
+}
+
+
 void dwarf_finish(struct dwarf_info *dinfo)
 {
+  lbuf_flush(dinfo);
+
   /* close .debug_aranges table with two NULL-entries and set its size */
   add_data_atom(dinfo->asec,dinfo->addr_len,dinfo->addr_len,0);
   add_data_atom(dinfo->asec,dinfo->addr_len,dinfo->addr_len,0);
@@ -319,15 +403,13 @@ void dwarf_finish(struct dwarf_info *dinfo)
 
 static void dwarf_set_address(struct dwarf_info *dinfo,symbol *sym)
 {
-  static unsigned char opcode[3] = { 0,0,DW_LNE_set_address };
-  atom *a;
-
   /* extended opcode to set address for current cpu including relocation */
-  opcode[1] = dinfo->addr_len + 1;
-  add_char_atom(dinfo->lsec,opcode,3);
-  a = add_data_atom(dinfo->lsec,dinfo->addr_len,1,sym->pc);
-  add_extnreloc(&a->content.db->relocs,sym,sym->pc,REL_ABS,
-                0,dinfo->addr_len*BITSPERBYTE,0);
+  lbuf_byte(dinfo,0);
+  lbuf_byte(dinfo,dinfo->addr_len+1);
+  lbuf_byte(dinfo,DW_LNE_set_address);
+  setval(BIGENDIAN,lbuf_room(dinfo,dinfo->addr_len),dinfo->addr_len,sym->pc);
+  add_extnreloc(&dinfo->lrelocs,sym,sym->pc,REL_ABS,
+                0,dinfo->addr_len*BITSPERBYTE,dinfo->llen-dinfo->addr_len);
 }
 
 
@@ -349,12 +431,14 @@ static void set_atom_val(atom *a,size_t len,taddr val)
 void dwarf_end_sequence(struct dwarf_info *dinfo,section *sec)
 {
   if (!dinfo->end_sequence) {
-    static unsigned char opcode[3] = { 0,1,DW_LNE_end_sequence };
     symbol *sym = new_tmplabel(sec);  /* label at end of section */
     atom *a;
 
     dwarf_set_address(dinfo,sym);
-    add_char_atom(dinfo->lsec,opcode,3);
+    lbuf_byte(dinfo,0);
+    lbuf_byte(dinfo,1);
+    lbuf_byte(dinfo,DW_LNE_end_sequence);
+    lbuf_flush(dinfo);
     dinfo->end_sequence = 1;
 
     /* enter section size for this sequence into the address-range table */
@@ -451,16 +535,16 @@ void dwarf_line(struct dwarf_info *dinfo,section *sec,source *src)
     dwarf_set_address(dinfo,new_tmplabel(sec));
 
     if (file != dinfo->file) {
-      add_data_atom(dinfo->lsec,1,1,DW_LNS_set_file);
-      add_leb128_atom(dinfo->lsec,file);
+      lbuf_byte(dinfo,DW_LNS_set_file);
+      lbuf_leb128(dinfo,file);
       dinfo->file = file;
     }
     if (line != dinfo->line) {
-      add_data_atom(dinfo->lsec,1,1,DW_LNS_advance_line);
-      add_sleb128_atom(dinfo->lsec,line-dinfo->line);
+      lbuf_byte(dinfo,DW_LNS_advance_line);
+      lbuf_sleb128(dinfo,line-dinfo->line);
       dinfo->line = line;
     }
-    add_data_atom(dinfo->lsec,1,1,DW_LNS_copy);
+    lbuf_byte(dinfo,DW_LNS_copy);
   }
   else {
     int lineoffs = line - dinfo->line;
@@ -468,21 +552,21 @@ void dwarf_line(struct dwarf_info *dinfo,section *sec,source *src)
     int spc_op;
 
     if (file != dinfo->file) {
-      add_data_atom(dinfo->lsec,1,1,DW_LNS_set_file);
-      add_leb128_atom(dinfo->lsec,file);
+      lbuf_byte(dinfo,DW_LNS_set_file);
+      lbuf_leb128(dinfo,file);
       dinfo->file = file;
     }
 
     if (instoffs > dinfo->max_pcadvance) {
       if (instoffs - dinfo->max_pcadvance <= dinfo->max_pcadvance) {
         /* const_add_pc for up to twice the maximum special opcode advance */
-        add_data_atom(dinfo->lsec,1,1,DW_LNS_const_add_pc);
+        lbuf_byte(dinfo,DW_LNS_const_add_pc);
         instoffs -= dinfo->max_pcadvance;
       }
       else {
         /* advance address by standard opcode */
-        add_data_atom(dinfo->lsec,1,1,DW_LNS_advance_pc);
-        add_leb128_atom(dinfo->lsec,instoffs);
+        lbuf_byte(dinfo,DW_LNS_advance_pc);
+        lbuf_leb128(dinfo,instoffs);
         instoffs = 0;
       }
     }
@@ -490,8 +574,8 @@ void dwarf_line(struct dwarf_info *dinfo,section *sec,source *src)
     if (lineoffs < dinfo->line_base ||
         lineoffs >= dinfo->line_base + dinfo->line_range) {
       /* we have to advance line by standard opcode */
-      add_data_atom(dinfo->lsec,1,1,DW_LNS_advance_line);
-      add_sleb128_atom(dinfo->lsec,lineoffs);
+      lbuf_byte(dinfo,DW_LNS_advance_line);
+      lbuf_sleb128(dinfo,lineoffs);
       lineoffs = 0;
     }
 
@@ -502,17 +586,17 @@ void dwarf_line(struct dwarf_info *dinfo,section *sec,source *src)
     if (spc_op<0 || spc_op>0xff) {
       /* not representable as a special opcode, so emit standard opcodes */
       if (instoffs == dinfo->max_pcadvance)
-        add_data_atom(dinfo->lsec,1,1,DW_LNS_const_add_pc);
+        lbuf_byte(dinfo,DW_LNS_const_add_pc);
       else if (instoffs)
         ierror(0);
       if (lineoffs) {
-        add_data_atom(dinfo->lsec,1,1,DW_LNS_advance_line);
-        add_sleb128_atom(dinfo->lsec,lineoffs);
+        lbuf_byte(dinfo,DW_LNS_advance_line);
+        lbuf_sleb128(dinfo,lineoffs);
       }
-      add_data_atom(dinfo->lsec,1,1,DW_LNS_copy);  /* new matrix entry */
+      lbuf_byte(dinfo,DW_LNS_copy);  /* new matrix entry */
     }
     else
-      add_data_atom(dinfo->lsec,1,1,spc_op);  /* matrix entry by special op */
+      lbuf_byte(dinfo,spc_op);  /* matrix entry by special op */
 
     /* update line/address */
     dinfo->address = sec->pc;
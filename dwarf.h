@@ -21,6 +21,9 @@ struct dwarf_info {
   int max_pcadvance;
   taddr address;
   int file,line,column,is_stmt,basic_block,end_sequence;
+  uint8_t *lbuf;  /* line program of the current sequence */
+  size_t llen,lsize;
+  rlist *lrelocs;
 };
 
 /* debug information tags and attributes */
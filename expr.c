@@ -6,6 +6,7 @@
 char current_pc_char='$';
 int unsigned_shift;
 int charsperexp;
+unsigned long curpc_refs;  /* number of current-pc expressions created */
 
 static char *s;
 static symbol *cpc;
@@ -78,6 +79,7 @@ expr *curpc_expr(void)
     cpc->type=LABSYM;
     cpc->flags|=VASMINTERN|PROTECTED;
   }
+  curpc_refs++;
   return new_sym_expr(cpc);
 }
 
@@ -1055,6 +1057,7 @@ int eval_expr(expr *tree,taddr *result,section *sec,taddr pc)
 
   if(!tree)
     ierror(0);
+  hot_stats[HS_EVAL_NODES]++;
   if(tree->left&&!eval_expr(tree->left,&lval,sec,pc))
     cnst=0;
   if(tree->right&&!eval_expr(tree->right,&rval,sec,pc))
@@ -1494,6 +1497,7 @@ static int _find_base(expr *p,symbol **base,section *sec,taddr pc)
    Note: Does not find all possible solutions. */
 int find_base(expr *p,symbol **base,section *sec,taddr pc)
 {
+  hot_stats[HS_FIND_BASE]++;
   if(base)
     *base=NULL;
   return _find_base(p,base,sec,pc);
@@ -40,6 +40,7 @@ struct expr {
 extern char current_pc_char;
 extern int unsigned_shift;
 extern int charsperexp;
+extern unsigned long curpc_refs;
 
 /* functions */
 int init_expr(void);
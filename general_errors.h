@@ -87,3 +87,12 @@
   "missing definition for symbol <%s>",NOLINE|WARNING,
   "additional macro arguments ignored (expecting %d)",WARNING,
   "macro previously defined at line %d of %s",WARNING,
+  "option %s cannot be used with -batch",NOLINE|ERROR,
+  "no worker processes for -batch on this host",NOLINE|ERROR|FATAL, /* 90 */
+  "batch job \"%s\" needs an existing input and an output name",NOLINE|ERROR,
+  "option %s cannot be used with source from stdin",NOLINE|ERROR,
+  "symbol <%s> cannot be stored in a precompiled header",NOLINE|WARNING,
+  "section <%s>: no code or data allowed in a precompiled header",NOLINE|ERROR,
+  "precompiled header <%s> ignored: %s",NOLINE|WARNING,         /* 95 */
+  "precompiled header <%s> ignored: <%s> has changed",NOLINE|WARNING,
+  "cannot start a worker process for batch job \"%s\"",NOLINE|ERROR,
@@ -1,7 +1,13 @@
 /* osdep.c - OS-dependant routines */
 /* (c) in 2018,2020,2024 by Frank Wille */
 
+#if defined(UNIX) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 199309L  /* clock_gettime() */
+#endif
+#include <stdio.h>
 #include <string.h>
+#include <time.h>
+#include <errno.h>
 char *mystrdup(const char *);
 void *mymalloc(size_t);
 struct symbol *internal_abs(char *);
@@ -10,6 +16,8 @@ struct symbol *internal_abs(char *);
 
 #if defined(UNIX)
 #include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
 
 #elif defined(AMIGA)
 #include <dos/dos.h>
@@ -210,6 +218,93 @@ char *get_workdir(void)
 }
 #endif
 
+/* return a monotonic time in seconds, for measuring intervals */
+#if defined(UNIX) && defined(CLOCK_MONOTONIC)
+double get_timer(void)
+{
+  struct timespec ts;
+
+  if (clock_gettime(CLOCK_MONOTONIC,&ts) == 0)
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+  return (double)clock() / CLOCKS_PER_SEC;
+}
+
+#elif defined(_WIN32)
+double get_timer(void)
+{
+  static LARGE_INTEGER freq;
+  LARGE_INTEGER cnt;
+
+  if (freq.QuadPart == 0)
+    QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&cnt);
+  return (double)cnt.QuadPart / (double)freq.QuadPart;
+}
+
+#else  /* portable default: processor time */
+double get_timer(void)
+{
+  return (double)clock() / CLOCKS_PER_SEC;
+}
+#endif
+
+/* number of processors, for the default number of parallel jobs */
+int num_cpus(void)
+{
+#if defined(UNIX) && defined(_SC_NPROCESSORS_ONLN)
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return n>0 ? (int)n : 1;
+#else
+  return 1;
+#endif
+}
+
+
+#if defined(UNIX)
+/* Start a worker process, which writes its output into out and err.
+   Returns 0 in the worker and a job handle in the caller, or -1 when
+   no worker could be started. */
+long start_job(FILE *out,FILE *err)
+{
+  pid_t pid;
+
+  fflush(stdout);
+  fflush(stderr);
+  if ((pid = fork()) == 0) {
+    dup2(fileno(out),STDOUT_FILENO);
+    dup2(fileno(err),STDERR_FILENO);
+  }
+  return pid<0 ? -1 : (long)pid;
+}
+
+/* Wait for any worker to finish and return its handle, or -1 when there
+   are no workers. failed is set when the worker did not exit successfully. */
+long wait_job(int *failed)
+{
+  pid_t pid;
+  int status;
+
+  while ((pid = wait(&status)) < 0) {
+    if (errno != EINTR)
+      return -1;
+  }
+  *failed = !WIFEXITED(status) || WEXITSTATUS(status)!=0;
+  return (long)pid;
+}
+
+#else  /* no worker processes */
+long start_job(FILE *out,FILE *err)
+{
+  return -1;
+}
+
+long wait_job(int *failed)
+{
+  return -1;
+}
+#endif
+
 int init_osdep(void)
 {
 #if defined(UNIX)
@@ -13,4 +13,8 @@ char *remove_path_delimiter(const char *);
 char *get_filepart(char *);
 int abs_path(const char *);
 char *get_workdir(void);
+double get_timer(void);
+int num_cpus(void);
+long start_job(FILE *,FILE *);
+long wait_job(int *);
 int init_osdep(void);
@@ -475,6 +475,7 @@ static void write_output(FILE *f,section *sec,symbol *sym)
   int num_areas;
 
   strtab_hash = new_hashtable(AOFSTRHTABSIZE);
+  strtab_hash->name = "AOF strings";
   idfn_str = make_idfn();
   idfn_len = strlen(idfn_str) + 1;
 
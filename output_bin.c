@@ -79,6 +79,10 @@ static void write_output(FILE *f,section *sec,symbol *sym)
     *slp++ = s;
   }
   nsecs = slp - seclist;  /* update count to actual sections added */
+  if (nsecs == 0) {
+    myfree(seclist);
+    return;  /* nothing to write */
+  }
   if (nsecs > 1)
     qsort(seclist,nsecs,sizeof(section *),orgcmp);
 
@@ -13,8 +13,8 @@ static int be,cpu,bits;
 static unsigned elfrelsize,shtreloc;
 
 static hashtable *elfsymhash;
-static struct list shdrlist,symlist,relalist;
-static struct StrTabList shstrlist,strlist,stabstrlist;
+static struct ElfBuf shdrtab,symtab,reltab;
+static struct StrTab shstrtab,strtab,stabstrtab;
 
 static unsigned symtabidx,strtabidx,shstrtabidx;
 static unsigned symindex,shdrindex;
@@ -23,134 +23,170 @@ static utaddr stablen;
 static char stabname[] = ".stab";
 
 
-static unsigned addString(struct StrTabList *sl,const char *s)
+static void *addBuf(struct ElfBuf *b,size_t n)
+/* append n zeroed bytes to a buffer */
 {
-  struct StrTabNode *sn = mymalloc(sizeof(struct StrTabNode));
-  unsigned idx = sl->index;
+  void *p;
 
-  sn->str = s;
-  addtail(&(sl->l),&(sn->n));
-  sl->index += (unsigned)strlen(s) + 1;
-  return idx;
+  if (b->len+n > b->size) {
+    b->size = b->size ? b->size*2 : ELFBUFINC;
+    if (b->size < b->len+n)
+      b->size = (b->len+n+ELFBUFINC-1) & ~(ELFBUFINC-1);
+    b->data = myrealloc(b->data,b->size);
+  }
+  p = b->data + b->len;
+  b->len += n;
+  return memset(p,0,n);
+}
+
+
+static void initStrTab(struct StrTab *st)
+{
+  st->b.len = 0;
+  st->hash = new_hashtable(ELFSTRHTABSIZE);
+  st->hash->name = "ELF strings";
+}
+
+
+static unsigned addStringHash(struct StrTab *st,const char *s,size_t hc)
+/* add a string with known hash code to a table, when not already present,
+   and return its offset */
+{
+  hashdata data;
+  size_t len;
+
+  if (find_name_hc(st->hash,s,hc,&data))
+    return data.idx;
+  len = strlen(s) + 1;
+  data.idx = (uint32_t)st->b.len;
+  memcpy(addBuf(&st->b,len),s,len);
+  add_hashentry_hc(st->hash,s,hc,data);
+  return data.idx;
+}
+
+
+static unsigned addString(struct StrTab *st,const char *s)
+{
+  return addStringHash(st,s,hashcode(s));
 }
 
 
 static void init_lists(void)
 {
   elfsymhash = new_hashtable(ELFSYMHTABSIZE);
-  initlist(&shdrlist);
-  initlist(&symlist);
-  initlist(&relalist);
-  shstrlist.index = strlist.index = 0;
-  initlist(&shstrlist.l);
-  initlist(&strlist.l);
+  elfsymhash->name = "ELF symbols";
+  shdrtab.len = symtab.len = reltab.len = 0;
+  initStrTab(&shstrtab);
+  initStrTab(&strtab);
   symindex = shdrindex = stabidx = 0;
-  addString(&shstrlist,emptystr);  /* first string is always "" */
-  symtabidx = addString(&shstrlist,".symtab");
-  strtabidx = addString(&shstrlist,".strtab");
-  shstrtabidx = addString(&shstrlist,".shstrtab");
-  addString(&strlist,emptystr);
+  addString(&shstrtab,emptystr);  /* first string is always "" */
+  symtabidx = addString(&shstrtab,".symtab");
+  strtabidx = addString(&shstrtab,".strtab");
+  shstrtabidx = addString(&shstrtab,".shstrtab");
+  addString(&strtab,emptystr);
   if (!no_symbols && first_nlist) {
-    initlist(&stabstrlist.l);
-    addString(&stabstrlist,emptystr);
+    initStrTab(&stabstrtab);
+    addString(&stabstrtab,emptystr);
   }
 }
 
 
-static struct Shdr32Node *addShdr32(void)
-{
-  struct Shdr32Node *s = mycalloc(sizeof(struct Shdr32Node));
+#define SHDR32(i) (&((struct Elf32_Shdr *)shdrtab.data)[i])
+#define SHDR64(i) (&((struct Elf64_Shdr *)shdrtab.data)[i])
+#define SYM32(i) (&((struct Elf32_Sym *)symtab.data)[i])
+#define SYM64(i) (&((struct Elf64_Sym *)symtab.data)[i])
 
-  addtail(&shdrlist,&(s->n));
-  shdrindex++;
-  return s;
+
+static unsigned addShdr32(void)
+{
+  addBuf(&shdrtab,sizeof(struct Elf32_Shdr));
+  return shdrindex++;
 }
 
 
-static struct Shdr64Node *addShdr64(void)
+static unsigned addShdr64(void)
 {
-  struct Shdr64Node *s = mycalloc(sizeof(struct Shdr64Node));
-
-  addtail(&shdrlist,&(s->n));
-  shdrindex++;
-  return s;
+  addBuf(&shdrtab,sizeof(struct Elf64_Shdr));
+  return shdrindex++;
 }
 
 
-static struct Symbol32Node *addSymbol32(const char *name)
+static struct Elf32_Sym *addSymbol32(const char *name)
+/* name must be interned, its hash code is shared by both tables */
 {
-  struct Symbol32Node *sn = mycalloc(sizeof(struct Symbol32Node));
+  struct Elf32_Sym *s = addBuf(&symtab,sizeof(struct Elf32_Sym));
   hashdata data;
 
-  addtail(&symlist,&(sn->n));
+  data.idx = symindex++;
   if (name) {
-    sn->name = name;
-    setval(be,sn->s.st_name,4,addString(&strlist,name));
+    size_t hc = interned_hash(name);
+
+    setval(be,s->st_name,4,addStringHash(&strtab,name,hc));
+    add_hashentry_hc(elfsymhash,name,hc,data);
   }
-  data.ptr = sn;
-  sn->idx = symindex++;
-  add_hashentry(elfsymhash,name?name:emptystr,data,0);
-  return sn;
+  else
+    add_hashentry(elfsymhash,emptystr,data,0);
+  return s;
 }
 
 
-static struct Symbol64Node *addSymbol64(const char *name)
+static struct Elf64_Sym *addSymbol64(const char *name)
+/* name must be interned, its hash code is shared by both tables */
 {
-  struct Symbol64Node *sn = mycalloc(sizeof(struct Symbol64Node));
+  struct Elf64_Sym *s = addBuf(&symtab,sizeof(struct Elf64_Sym));
   hashdata data;
 
-  addtail(&symlist,&(sn->n));
+  data.idx = symindex++;
   if (name) {
-    sn->name = name;
-    setval(be,sn->s.st_name,4,addString(&strlist,name));
+    size_t hc = interned_hash(name);
+
+    setval(be,s->st_name,4,addStringHash(&strtab,name,hc));
+    add_hashentry_hc(elfsymhash,name,hc,data);
   }
-  data.ptr = sn;
-  sn->idx = symindex++;
-  add_hashentry(elfsymhash,name?name:emptystr,data,0);
-  return sn;
+  else
+    add_hashentry(elfsymhash,emptystr,data,0);
+  return s;
 }
 
 
 static void newSym32(const char *name,elfull value,elfull size,uint8_t bind,
                      uint8_t type,unsigned shndx)
 {
-  struct Symbol32Node *elfsym = addSymbol32(name);
+  struct Elf32_Sym *elfsym = addSymbol32(name);
 
-  setval(be,elfsym->s.st_value,4,value);
-  setval(be,elfsym->s.st_size,4,size);
-  elfsym->s.st_info[0] = ELF32_ST_INFO(bind,type);
-  setval(be,elfsym->s.st_shndx,2,shndx);
+  setval(be,elfsym->st_value,4,value);
+  setval(be,elfsym->st_size,4,size);
+  elfsym->st_info[0] = ELF32_ST_INFO(bind,type);
+  setval(be,elfsym->st_shndx,2,shndx);
 }
 
 
 static void newSym64(const char *name,elfull value,elfull size,uint8_t bind,
                      uint8_t type,unsigned shndx)
 {
-  struct Symbol64Node *elfsym = addSymbol64(name);
+  struct Elf64_Sym *elfsym = addSymbol64(name);
 
-  setval(be,elfsym->s.st_value,8,value);
-  setval(be,elfsym->s.st_size,8,size);
-  elfsym->s.st_info[0] = ELF64_ST_INFO(bind,type);
-  setval(be,elfsym->s.st_shndx,2,shndx);
+  setval(be,elfsym->st_value,8,value);
+  setval(be,elfsym->st_size,8,size);
+  elfsym->st_info[0] = ELF64_ST_INFO(bind,type);
+  setval(be,elfsym->st_shndx,2,shndx);
 }
 
 
 static void addRel32(elfull o,elfull a,elfull i,elfull r)
 {
   if (RELA) {
-    struct Rela32Node *rn = mymalloc(sizeof(struct Rela32Node));
+    struct Elf32_Rela *rn = addBuf(&reltab,sizeof(struct Elf32_Rela));
 
-    setval(be,rn->r.r_offset,4,o);
-    setval(be,rn->r.r_addend,4,a);
-    setval(be,rn->r.r_info,4,ELF32_R_INFO(i,r));
-    addtail(&relalist,&(rn->n));
+    setval(be,rn->r_offset,4,o);
+    setval(be,rn->r_addend,4,a);
+    setval(be,rn->r_info,4,ELF32_R_INFO(i,r));
   }
   else {
-    struct Rel32Node *rn = mymalloc(sizeof(struct Rel32Node));
+    struct Elf32_Rel *rn = addBuf(&reltab,sizeof(struct Elf32_Rel));
 
-    setval(be,rn->r.r_offset,4,o);
-    setval(be,rn->r.r_info,4,ELF32_R_INFO(i,r));
-    addtail(&relalist,&(rn->n));
+    setval(be,rn->r_offset,4,o);
+    setval(be,rn->r_info,4,ELF32_R_INFO(i,r));
   }
 }
 
@@ -158,68 +194,66 @@ static void addRel32(elfull o,elfull a,elfull i,elfull r)
 static void addRel64(elfull o,elfull a,elfull i,elfull r)
 {
   if (RELA) {
-    struct Rela64Node *rn = mymalloc(sizeof(struct Rela64Node));
+    struct Elf64_Rela *rn = addBuf(&reltab,sizeof(struct Elf64_Rela));
 
-    setval(be,rn->r.r_offset,8,o);
-    setval(be,rn->r.r_addend,8,a);
-    setval(be,rn->r.r_info,8,ELF64_R_INFO(i,r));
-    addtail(&relalist,&(rn->n));
+    setval(be,rn->r_offset,8,o);
+    setval(be,rn->r_addend,8,a);
+    setval(be,rn->r_info,8,ELF64_R_INFO(i,r));
   }
   else {
-    struct Rel64Node *rn = mymalloc(sizeof(struct Rel64Node));
+    struct Elf64_Rel *rn = addBuf(&reltab,sizeof(struct Elf64_Rel));
 
-    setval(be,rn->r.r_offset,8,o);
-    setval(be,rn->r.r_info,8,ELF64_R_INFO(i,r));
-    addtail(&relalist,&(rn->n));
+    setval(be,rn->r_offset,8,o);
+    setval(be,rn->r_info,8,ELF64_R_INFO(i,r));
   }
 }
 
 
-static void *makeShdr32(elfull name,elfull type,elfull flags,elfull offset,
-                        elfull size,elfull info,elfull align,elfull entsize)
+static unsigned makeShdr32(elfull name,elfull type,elfull flags,elfull offset,
+                           elfull size,elfull info,elfull align,elfull entsize)
 {
-  struct Shdr32Node *shn;
+  unsigned idx = addShdr32();
+  struct Elf32_Shdr *sh = SHDR32(idx);
 
-  shn = addShdr32();
-  setval(be,shn->s.sh_name,4,name);
-  setval(be,shn->s.sh_type,4,type);
-  setval(be,shn->s.sh_flags,4,flags);
-  setval(be,shn->s.sh_offset,4,offset);
-  setval(be,shn->s.sh_size,4,size);
-  setval(be,shn->s.sh_info,4,info);
-  setval(be,shn->s.sh_addralign,4,align);
-  setval(be,shn->s.sh_entsize,4,entsize);
+  setval(be,sh->sh_name,4,name);
+  setval(be,sh->sh_type,4,type);
+  setval(be,sh->sh_flags,4,flags);
+  setval(be,sh->sh_offset,4,offset);
+  setval(be,sh->sh_size,4,size);
+  setval(be,sh->sh_info,4,info);
+  setval(be,sh->sh_addralign,4,align);
+  setval(be,sh->sh_entsize,4,entsize);
   /* @@@ set sh_addr to org? */
-  return shn;
+  return idx;
 }
 
 
-static void *makeShdr64(elfull name,elfull type,elfull flags,elfull offset,
-                        elfull size,elfull info,elfull align,elfull entsize)
+static unsigned makeShdr64(elfull name,elfull type,elfull flags,elfull offset,
+                           elfull size,elfull info,elfull align,elfull entsize)
 {
-  struct Shdr64Node *shn;
+  unsigned idx = addShdr64();
+  struct Elf64_Shdr *sh = SHDR64(idx);
 
-  shn = addShdr64();
-  setval(be,shn->s.sh_name,4,name);
-  setval(be,shn->s.sh_type,4,type);
-  setval(be,shn->s.sh_flags,8,flags);
-  setval(be,shn->s.sh_offset,8,offset);
-  setval(be,shn->s.sh_size,8,size);
-  setval(be,shn->s.sh_info,4,info);
-  setval(be,shn->s.sh_addralign,8,align);
-  setval(be,shn->s.sh_entsize,8,entsize);
+  setval(be,sh->sh_name,4,name);
+  setval(be,sh->sh_type,4,type);
+  setval(be,sh->sh_flags,8,flags);
+  setval(be,sh->sh_offset,8,offset);
+  setval(be,sh->sh_size,8,size);
+  setval(be,sh->sh_info,4,info);
+  setval(be,sh->sh_addralign,8,align);
+  setval(be,sh->sh_entsize,8,entsize);
   /* @@@ set sh_addr to org? */
-  return shn;
+  return idx;
 }
 
 
 static unsigned findelfsymbol(const char *name)
-/* find symbol with given name in symlist, return its index */
+/* find symbol with given interned name in symtab, return its index */
 {
   hashdata data;
 
-  if (find_name(elfsymhash,name,&data))
-    return ((struct Symbol32Node *)data.ptr)->idx;
+  if (find_name_hc(elfsymhash,name,interned_hash(name),&data))
+    return data.idx;
   return 0;
 }
 
@@ -425,8 +459,8 @@ static utaddr make_stabreloc(utaddr pc,struct stabdef *nlist,
 
 /* create .rel(a)XXX section header */
 static void make_relsechdr(const char *sname,utaddr roffs,utaddr len,unsigned idx,
-                           void *(*makeshdr)(elfull,elfull,elfull,elfull,
-                                             elfull,elfull,elfull,elfull))
+                           unsigned (*makeshdr)(elfull,elfull,elfull,elfull,
+                                                elfull,elfull,elfull,elfull))
 {
   char *rname = mymalloc(strlen(sname) + 6);
  
@@ -435,15 +469,15 @@ static void make_relsechdr(const char *sname,utaddr roffs,utaddr len,unsigned id
   else
     sprintf(rname,".rel%s",sname);
 
-  makeshdr(addString(&shstrlist,rname),shtreloc,0,
+  makeshdr(addString(&shstrtab,rname),shtreloc,0,
            roffs, /* relative offset - will be fixed later! */
            len,idx,bytespertaddr,elfrelsize);
 }
 
 
 static utaddr prog_sec_hdrs(section *sec,utaddr soffset,
-                            void *(*makeshdr)(elfull,elfull,elfull,elfull,
-                                              elfull,elfull,elfull,elfull),
+                            unsigned (*makeshdr)(elfull,elfull,elfull,elfull,
+                                                 elfull,elfull,elfull,elfull),
                             void (*newsym)(const char *,elfull,elfull,
                                            uint8_t,uint8_t,
                                            unsigned))
@@ -461,7 +495,7 @@ static utaddr prog_sec_hdrs(section *sec,utaddr soffset,
       newsym(NULL,0,0,STB_LOCAL,STT_SECTION,shdrindex);
 
       secp->idx = shdrindex;
-      makeshdr(addString(&shstrlist,secp->name),
+      makeshdr(addStringHash(&shstrtab,secp->name,interned_hash(secp->name)),
                type,get_sec_flags(secp->attr),soffset,
                get_sec_size(secp),0,secp->align,0);
 
@@ -474,7 +508,7 @@ static utaddr prog_sec_hdrs(section *sec,utaddr soffset,
 
   /* look for stabs (32 bits only) */
   if (!no_symbols && bits==32 && nlist!=NULL) {
-    struct Shdr32Node *shn;
+    unsigned shidx;
     const char *cuname = NULL;
 
     /* count them, set name of compilation unit */
@@ -485,24 +519,24 @@ static utaddr prog_sec_hdrs(section *sec,utaddr soffset,
       nlist = nlist->next;
     }
     /* add all symbol strings to .stabstr, cu name should be first(?) */
-    addString(&stabstrlist,cuname!=NULL?cuname:filename);
+    addString(&stabstrtab,cuname!=NULL?cuname:filename);
     nlist = first_nlist;
     while (nlist != NULL) {
       nlist->name.idx = nlist->name.ptr != NULL ?
-                        addString(&stabstrlist,nlist->name.ptr) : 0;
+                        addString(&stabstrtab,nlist->name.ptr) : 0;
       nlist = nlist->next;
     }
     /* make .stab section, preceded by a compilation unit header (stablen+1) */
     stabidx = shdrindex;
-    shn = makeshdr(addString(&shstrlist,stabname),SHT_PROGBITS,0,soffset,
-                   (stablen+1)*sizeof(struct nlist32),0,4,
-                   sizeof(struct nlist32));
+    shidx = makeshdr(addString(&shstrtab,stabname),SHT_PROGBITS,0,soffset,
+                     (stablen+1)*sizeof(struct nlist32),0,4,
+                     sizeof(struct nlist32));
     soffset += (stablen+1) * sizeof(struct nlist32);
-    setval(be,shn->s.sh_link,4,shdrindex);  /* associated .stabstr section */
+    setval(be,SHDR32(shidx)->sh_link,4,shdrindex);  /* assoc. .stabstr */
     /* make .stabstr section */
-    makeshdr(addString(&shstrlist,".stabstr"),SHT_STRTAB,0,soffset,
-             stabstrlist.index,0,1,0);
-    soffset += stabstrlist.index;
+    makeshdr(addString(&shstrtab,".stabstr"),SHT_STRTAB,0,soffset,
+             stabstrtab.b.len,0,1,0);
+    soffset += stabstrtab.b.len;
     stabstralign = balign(soffset,4);
     soffset += stabstralign;
   }
@@ -521,7 +555,7 @@ static unsigned build_symbol_table(symbol *first,
 
   /* file name symbol, when defined */
   if (filename)
-    newsym(filename,0,0,STB_LOCAL,STT_FILE,SHN_ABS);
+    newsym(intern_name(filename),0,0,STB_LOCAL,STT_FILE,SHN_ABS);
 
   if (!no_symbols)  /* symbols with local binding first */
     for (symp=first; symp; symp=symp->next)
@@ -549,8 +583,8 @@ static void make_reloc_sections(section *sec,
                                                uint8_t,uint8_t,
                                                unsigned),
                                 void (*addrel)(elfull,elfull,elfull,elfull),
-                                void *(*makeshdr)(elfull,elfull,elfull,elfull,
-                                                  elfull,elfull,elfull,elfull))
+                                unsigned (*makeshdr)(elfull,elfull,elfull,elfull,
+                                                     elfull,elfull,elfull,elfull))
 {
   struct stabdef *nlist = first_nlist;
   utaddr roffset = 0;
@@ -594,12 +628,9 @@ static void make_reloc_sections(section *sec,
 }
 
 
-static void write_strtab(FILE *f,struct StrTabList *strl)
+static void write_buf(FILE *f,struct ElfBuf *b)
 {
-  struct StrTabNode *stn;
-
-  while (stn = (struct StrTabNode *)remhead(&(strl->l)))
-    fwdata(f,stn->str,strlen(stn->str)+1);
+  fwdata(f,b->data,b->len);
 }
 
 
@@ -632,7 +663,7 @@ static void write_section_data(FILE *f,section *sec)
     /* write compilation unit header - precedes nlist entries */
     fw32(f,1,be);  /* source name is first entry in .stabstr */
     fw32(f,stablen,be);
-    fw32(f,stabstrlist.index,be);
+    fw32(f,stabstrtab.b.len,be);
     /* write .stab */
     while (nlist != NULL) {
       struct nlist32 n;
@@ -646,7 +677,7 @@ static void write_section_data(FILE *f,section *sec)
       nlist = nlist->next;
     }
     /* write .stabstr and align */
-    write_strtab(f,&stabstrlist);
+    write_buf(f,&stabstrtab.b);
     fwspace(f,stabstralign);
   }
 }
@@ -657,8 +688,7 @@ static void write_ELF64(FILE *f,section *sec,symbol *sym)
   struct Elf64_Ehdr header;
   unsigned firstglobal,align1,align2,i;
   utaddr soffset=sizeof(struct Elf64_Ehdr);
-  struct Shdr64Node *shn;
-  struct Symbol64Node *elfsym;
+  struct Elf64_Shdr *sh;
 
   elfrelsize = RELA ? sizeof(struct Elf64_Rela) : sizeof(struct Elf64_Rel);
 
@@ -682,8 +712,8 @@ static void write_ELF64(FILE *f,section *sec,symbol *sym)
 
   /* ".shstrtab" section header string table */
   makeShdr64(shstrtabidx,SHT_STRTAB,0,
-             soffset,shstrlist.index,0,1,0);
-  soffset += shstrlist.index;
+             soffset,shstrtab.b.len,0,1,0);
+  soffset += shstrtab.b.len;
   align1 = balign(soffset,4);
   soffset += align1;
 
@@ -694,15 +724,15 @@ static void write_ELF64(FILE *f,section *sec,symbol *sym)
   setval(be,header.e_shnum,2,shdrindex+2);
 
   /* ".symtab" symbol table */
-  shn = makeShdr64(symtabidx,SHT_SYMTAB,0,soffset,
-                   symindex*sizeof(struct Elf64_Sym),
-                   firstglobal,8,sizeof(struct Elf64_Sym));
-  setval(be,shn->s.sh_link,4,shdrindex);  /* associated .strtab section */
+  i = makeShdr64(symtabidx,SHT_SYMTAB,0,soffset,
+                 symindex*sizeof(struct Elf64_Sym),
+                 firstglobal,8,sizeof(struct Elf64_Sym));
+  setval(be,SHDR64(i)->sh_link,4,shdrindex);  /* associated .strtab section */
   soffset += symindex * sizeof(struct Elf64_Sym);
 
   /* ".strtab" string table */
-  makeShdr64(strtabidx,SHT_STRTAB,0,soffset,strlist.index,0,1,0);
-  soffset += strlist.index;
+  makeShdr64(strtabidx,SHT_STRTAB,0,soffset,strtab.b.len,0,1,0);
+  soffset += strtab.b.len;
   align2 = balign(soffset,4);
   soffset += align2;  /* offset for first Reloc-entry */
 
@@ -713,42 +743,28 @@ static void write_ELF64(FILE *f,section *sec,symbol *sym)
   write_section_data(f,sec);
 
   /* write .shstrtab string table */
-  write_strtab(f,&shstrlist);
+  write_buf(f,&shstrtab.b);
 
   /* write section headers */
   fwspace(f,align1);
-  i = 0;
-  while (shn = (struct Shdr64Node *)remhead(&shdrlist)) {
-    if (readval(be,shn->s.sh_type,4) == shtreloc) {
+  for (i=0,sh=SHDR64(0); i<shdrindex; i++,sh++) {
+    if (readval(be,sh->sh_type,4) == shtreloc) {
       /* set correct offset and link to symtab */
-      setval(be,shn->s.sh_offset,8,readval(be,shn->s.sh_offset,8)+soffset);
-      setval(be,shn->s.sh_link,4,shdrindex-2); /* index of associated symtab */
+      setval(be,sh->sh_offset,8,readval(be,sh->sh_offset,8)+soffset);
+      setval(be,sh->sh_link,4,shdrindex-2); /* index of associated symtab */
     }
-    fwdata(f,&(shn->s),sizeof(struct Elf64_Shdr));
-    i++;
   }
+  write_buf(f,&shdrtab);
 
   /* write symbol table */
-  while (elfsym = (struct Symbol64Node *)remhead(&symlist))
-    fwdata(f,&(elfsym->s),sizeof(struct Elf64_Sym));
+  write_buf(f,&symtab);
 
   /* write .strtab string table */
-  write_strtab(f,&strlist);
+  write_buf(f,&strtab.b);
 
   /* write relocations */
   fwspace(f,align2);
-  if (RELA) {
-    struct Rela64Node *rn;
-
-    while (rn = (struct Rela64Node *)remhead(&relalist))
-      fwdata(f,&(rn->r),sizeof(struct Elf64_Rela));
-  }
-  else {
-    struct Rel64Node *rn;
-
-    while (rn = (struct Rel64Node *)remhead(&relalist))
-      fwdata(f,&(rn->r),sizeof(struct Elf64_Rel));
-  }
+  write_buf(f,&reltab);
 }
 
 
@@ -757,8 +773,7 @@ static void write_ELF32(FILE *f,section *sec,symbol *sym)
   struct Elf32_Ehdr header;
   unsigned firstglobal,align1,align2,i;
   utaddr soffset=sizeof(struct Elf32_Ehdr);
-  struct Shdr32Node *shn;
-  struct Symbol32Node *elfsym;
+  struct Elf32_Shdr *sh;
 
   elfrelsize = RELA ? sizeof(struct Elf32_Rela) : sizeof(struct Elf32_Rel);
 
@@ -785,8 +800,8 @@ static void write_ELF32(FILE *f,section *sec,symbol *sym)
 
   /* ".shstrtab" section header string table */
   makeShdr32(shstrtabidx,SHT_STRTAB,0,
-             soffset,shstrlist.index,0,1,0);
-  soffset += shstrlist.index;
+             soffset,shstrtab.b.len,0,1,0);
+  soffset += shstrtab.b.len;
   align1 = balign(soffset,4);
   soffset += align1;
 
@@ -797,15 +812,15 @@ static void write_ELF32(FILE *f,section *sec,symbol *sym)
   setval(be,header.e_shnum,2,shdrindex+2);
 
   /* ".symtab" symbol table */
-  shn = makeShdr32(symtabidx,SHT_SYMTAB,0,soffset,
-                   symindex*sizeof(struct Elf32_Sym),
-                   firstglobal,4,sizeof(struct Elf32_Sym));
-  setval(be,shn->s.sh_link,4,shdrindex);  /* associated .strtab section */
+  i = makeShdr32(symtabidx,SHT_SYMTAB,0,soffset,
+                 symindex*sizeof(struct Elf32_Sym),
+                 firstglobal,4,sizeof(struct Elf32_Sym));
+  setval(be,SHDR32(i)->sh_link,4,shdrindex);  /* associated .strtab section */
   soffset += symindex * sizeof(struct Elf32_Sym);
 
   /* ".strtab" string table */
-  makeShdr32(strtabidx,SHT_STRTAB,0,soffset,strlist.index,0,1,0);
-  soffset += strlist.index;
+  makeShdr32(strtabidx,SHT_STRTAB,0,soffset,strtab.b.len,0,1,0);
+  soffset += strtab.b.len;
   align2 = balign(soffset,4);
   soffset += align2;  /* offset for first Reloc-entry */
 
@@ -816,42 +831,28 @@ static void write_ELF32(FILE *f,section *sec,symbol *sym)
   write_section_data(f,sec);
 
   /* write .shstrtab string table */
-  write_strtab(f,&shstrlist);
+  write_buf(f,&shstrtab.b);
 
   /* write section headers */
   fwspace(f,align1);
-  i = 0;
-  while (shn = (struct Shdr32Node *)remhead(&shdrlist)) {
-    if (readval(be,shn->s.sh_type,4) == shtreloc) {
+  for (i=0,sh=SHDR32(0); i<shdrindex; i++,sh++) {
+    if (readval(be,sh->sh_type,4) == shtreloc) {
       /* set correct offset and link to symtab */
-      setval(be,shn->s.sh_offset,4,readval(be,shn->s.sh_offset,4)+soffset);
-      setval(be,shn->s.sh_link,4,shdrindex-2); /* index of associated symtab */
+      setval(be,sh->sh_offset,4,readval(be,sh->sh_offset,4)+soffset);
+      setval(be,sh->sh_link,4,shdrindex-2); /* index of associated symtab */
     }
-    fwdata(f,&(shn->s),sizeof(struct Elf32_Shdr));
-    i++;
   }
+  write_buf(f,&shdrtab);
 
   /* write symbol table */
-  while (elfsym = (struct Symbol32Node *)remhead(&symlist))
-    fwdata(f,&(elfsym->s),sizeof(struct Elf32_Sym));
+  write_buf(f,&symtab);
 
   /* write .strtab string table */
-  write_strtab(f,&strlist);
+  write_buf(f,&strtab.b);
 
   /* write relocations */
   fwspace(f,align2);
-  if (RELA) {
-    struct Rela32Node *rn;
-
-    while (rn = (struct Rela32Node *)remhead(&relalist))
-      fwdata(f,&(rn->r),sizeof(struct Elf32_Rela));
-  }
-  else {
-    struct Rel32Node *rn;
-
-    while (rn = (struct Rel32Node *)remhead(&relalist))
-      fwdata(f,&(rn->r),sizeof(struct Elf32_Rel));
-  }
+  write_buf(f,&reltab);
 }
 
 
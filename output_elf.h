@@ -242,58 +242,17 @@ struct Elf64_Rela {
 
 typedef uint64_t elfull;
 
-struct StrTabList {
-  struct list l;
-  unsigned index;
+/* growable buffer for the string tables, symbols, section headers and
+   relocations, which are written in one piece */
+struct ElfBuf {
+  uint8_t *data;
+  size_t len;
+  size_t size;
 };
 
-struct StrTabNode {
-  struct node n;
-  const char *str;
-};
-
-struct Shdr32Node {
-  struct node n;
-  struct Elf32_Shdr s;
-};
-
-struct Symbol32Node {
-  struct node n;
-  const char *name;
-  unsigned idx;
-  struct Elf32_Sym s;
-};
-
-struct Rela32Node {
-  struct node n;
-  struct Elf32_Rela r;
-};
-
-struct Rel32Node {
-  struct node n;
-  struct Elf32_Rel r;
-};
-
-struct Shdr64Node {
-  struct node n;
-  struct Elf64_Shdr s;
-};
-
-struct Symbol64Node {
-  struct node n;
-  const char *name;
-  unsigned idx;
-  struct Elf64_Sym s;
-};
-
-struct Rela64Node {
-  struct node n;
-  struct Elf64_Rela r;
-};
-
-struct Rel64Node {
-  struct node n;
-  struct Elf64_Rel r;
+struct StrTab {
+  struct ElfBuf b;
+  hashtable *hash;  /* offsets of all strings in the table */
 };
 
 #define RTYPE_ILLEGAL (~0)
@@ -318,3 +277,5 @@ struct Rel64Node {
 #endif
 
 #define ELFSYMHTABSIZE 0x10000
+#define ELFSTRHTABSIZE 0x1000
+#define ELFBUFINC 0x1000
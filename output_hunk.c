@@ -18,6 +18,17 @@ static int exthunk;
 static int genlinedebug;
 static int noabspath;
 static int keep_empty_sects;
+static int hunkstats;
+
+/* -hunkstats counters for the current hunk and totals */
+struct hunkstat {
+  unsigned long relocs;
+  unsigned long shortrelocs;
+  unsigned long blocks;
+  unsigned long xrefs;
+  unsigned long bytes;
+};
+static struct hunkstat hstat,hstat_total;
 
 static int debug_symbols; /* HUNK_SYMBOL output options */
 #define DBGSYM_STD 0      /* global symbols only (default) */
@@ -346,7 +357,7 @@ static utaddr sect_size(section *sec)
 }
 
 
-static struct hunkreloc *convert_reloc(atom *a,rlist *rl,utaddr pc)
+static int convert_reloc(atom *a,rlist *rl,utaddr pc,struct hunkreloc *hr)
 {
   int rtype = std_reloc(rl);
 
@@ -359,14 +370,13 @@ static struct hunkreloc *convert_reloc(atom *a,rlist *rl,utaddr pc)
     nreloc *r = (nreloc *)rl->reloc;
 
     if (LOCREF(r->sym)) {
-      struct hunkreloc *hr;
       uint32_t type;
       uint32_t offs = pc + r->byteoffset;
 
       switch (rtype) {
         case REL_ABS:
           if (r->size!=32 || r->bitoffset!=0 || r->mask!=DEFMASK)
-            return NULL;
+            return 0;
           type = HUNK_ABSRELOC32;
           break;
 
@@ -374,31 +384,31 @@ static struct hunkreloc *convert_reloc(atom *a,rlist *rl,utaddr pc)
           switch (r->size) {
             case 8:
               if (r->bitoffset!=0 || r->mask!=DEFMASK)
-                return NULL;
+                return 0;
               type = HUNK_RELRELOC8;
               break;
 #if defined(VASM_CPU_PPC)
             case 14:
               if (r->bitoffset!=0 || r->mask!=~3)
-                return NULL;
+                return 0;
               type = HUNK_RELRELOC16;
               break;
 #endif
             case 16:
               if (r->bitoffset!=0 || r->mask!=DEFMASK)
-                return NULL;
+                return 0;
               type = HUNK_RELRELOC16;
               break;
 #if defined(VASM_CPU_PPC)
             case 24:
               if (r->bitoffset!=6 || r->mask!=~3)
-                return NULL;
+                return 0;
               type = HUNK_RELRELOC26;
               break;
 #endif
             case 32:
               if (kick1 || r->bitoffset!=0 || r->mask!=DEFMASK)
-                return NULL;
+                return 0;
               type = HUNK_RELRELOC32;
               break;
           }
@@ -409,29 +419,28 @@ static struct hunkreloc *convert_reloc(atom *a,rlist *rl,utaddr pc)
 #endif
         case REL_SD:
           if (r->size!=16 || r->bitoffset!=0 || r->mask!=DEFMASK)
-            return NULL;
+            return 0;
           type = HUNK_DREL16;
           break;
 
         default:
-          return NULL;
+          return 0;
       }
 
-      hr = mymalloc(sizeof(struct hunkreloc));
       hr->a = a;
       hr->rl = rl;
       hr->hunk_id = type;
       hr->hunk_offset = offs;
       hr->hunk_index = r->sym->sec->idx;
-      return hr;
+      return 1;
     }
   }
 
-  return NULL;
+  return 0;
 }
 
 
-static struct hunkxref *convert_xref(rlist *rl,utaddr pc)
+static int convert_xref(rlist *rl,utaddr pc,struct hunkxref *xref)
 {
   int rtype = std_reloc(rl);
 
@@ -444,7 +453,6 @@ static struct hunkxref *convert_xref(rlist *rl,utaddr pc)
     nreloc *r = (nreloc *)rl->reloc;
 
     if (EXTREF(r->sym)) {
-      struct hunkxref *xref;
       uint32_t type,size=0;
       uint32_t offs = pc + r->byteoffset;
       int com = (r->sym->flags & COMMON) != 0;
@@ -452,7 +460,7 @@ static struct hunkxref *convert_xref(rlist *rl,utaddr pc)
       switch (rtype) {
         case REL_ABS:
           if (r->bitoffset!=0 || r->mask!=DEFMASK || (com && r->size!=32))
-            return NULL;
+            return 0;
           switch (r->size) {
             case 8:
               type = kick1 ? EXT_RELREF8 : EXT_ABSREF8;
@@ -475,31 +483,31 @@ static struct hunkxref *convert_xref(rlist *rl,utaddr pc)
           switch (r->size) {
             case 8:
               if (r->bitoffset!=0 || r->mask!=DEFMASK || com)
-                return NULL;
+                return 0;
               type = EXT_RELREF8;
               break;
 #if defined(VASM_CPU_PPC)
             case 14:
               if (r->bitoffset!=0 || r->mask!=~3 || com)
-                return NULL;
+                return 0;
               type = EXT_RELREF16;
               break;
 #endif
             case 16:
               if (r->bitoffset!=0 || r->mask!=DEFMASK || com)
-                return NULL;
+                return 0;
               type = EXT_RELREF16;
               break;
 #if defined(VASM_CPU_PPC)
             case 24:
               if (r->bitoffset!=6 || r->mask!=~3 || com)
-                return NULL;
+                return 0;
               type = EXT_RELREF26;
               break;
 #endif
             case 32:
               if (kick1 || r->bitoffset!=0 || r->mask!=DEFMASK)
-                return NULL;
+                return 0;
               if (com) {
                 type = EXT_RELCOMMON;
                 size = get_sym_size(r->sym);
@@ -515,89 +523,122 @@ static struct hunkxref *convert_xref(rlist *rl,utaddr pc)
 #endif
         case REL_SD:
           if (r->size!=16 || r->bitoffset!=0 || r->mask!=DEFMASK)
-            return NULL;
+            return 0;
           type = EXT_DEXT16;
           break;
 
         default:
-          return NULL;
+          return 0;
       }
 
-      xref = mymalloc(sizeof(struct hunkxref));
       xref->name = r->sym->name;
       xref->type = type;
       xref->size = size;
       xref->offset = offs;
-      return xref;
+      return 1;
     }
   }
 
-  return NULL;
+  return 0;
 }
 
 
-static void process_relocs(atom *a,struct list *reloclist,
-                           struct list *xreflist,section *sec,utaddr pc)
+static void *grow_array(void *p,size_t *size,size_t num,size_t elsize)
+/* make sure that there is room for one more element in the array */
+{
+  if (num >= *size) {
+    *size = *size ? *size*2 : HUNKRELOCINC;
+    p = myrealloc(p,*size*elsize);
+  }
+  return p;
+}
+
+
+static void process_relocs(atom *a,struct hunkrelocs *rels,
+                           struct hunkxrefs *xrefs,section *sec,utaddr pc)
 /* convert an atom's rlist into relocations and xrefs */
 {
   rlist *rl = get_relocs(a);
+  struct hunkreloc hr;
+  struct hunkxref xref;
 
   if (rl == NULL)
     return;
 
   do {
-    struct hunkreloc *hr = convert_reloc(a,rl,pc);
-
-    if (hr!=NULL && (xreflist!=NULL || hr->hunk_id==HUNK_ABSRELOC32 ||
-                     hr->hunk_id==HUNK_RELRELOC32)) {
-      addtail(reloclist,&hr->n);       /* add new relocation */
-      if ((hr->hunk_offset&1) && ((nreloc *)rl->reloc)->size > 8)
-        output_atom_error(22,a,sec->name,(unsigned long)hr->hunk_offset);
+    if (convert_reloc(a,rl,pc,&hr) &&
+        (xrefs!=NULL || hr.hunk_id==HUNK_ABSRELOC32 ||
+         hr.hunk_id==HUNK_RELRELOC32)) {
+      /* add new relocation */
+      rels->r = grow_array(rels->r,&rels->size,rels->num,
+                           sizeof(struct hunkreloc));
+      hr.seq = rels->num;
+      rels->r[rels->num++] = hr;
+      if ((hr.hunk_offset&1) && ((nreloc *)rl->reloc)->size > 8)
+        output_atom_error(22,a,sec->name,(unsigned long)hr.hunk_offset);
     }
-    else {
-      struct hunkxref *xref = convert_xref(rl,pc);
-
-      if (xref) {
-        if (xreflist) {
-          addtail(xreflist,&xref->n);  /* add new external reference */
-          if ((xref->offset&1) && ((nreloc *)rl->reloc)->size > 8)
-            output_atom_error(22,a,sec->name,(unsigned long)xref->offset);
-        }
-        else
-          output_atom_error(8,a,xref->name,sec->name,xref->offset,rl->type);
+    else if (convert_xref(rl,pc,&xref)) {
+      if (xrefs) {
+        /* add new external reference */
+        xrefs->x = grow_array(xrefs->x,&xrefs->size,xrefs->num,
+                              sizeof(struct hunkxref));
+        xref.seq = xrefs->num;
+        xrefs->x[xrefs->num++] = xref;
+        if ((xref.offset&1) && ((nreloc *)rl->reloc)->size > 8)
+          output_atom_error(22,a,sec->name,(unsigned long)xref.offset);
       }
       else
-        unsupp_reloc_error(a,rl);  /* reloc not supported */
+        output_atom_error(8,a,xref.name,sec->name,xref.offset,rl->type);
     }
+    else
+      unsupp_reloc_error(a,rl);  /* reloc not supported */
   }
   while (rl = rl->next);
 }
 
 
-static void reloc_hunk(FILE *f,uint32_t type,int shrt,struct list *reloclist)
-/* write all section-offsets for one relocation type */
+static int relcmp(const void *left,const void *right)
+/* sort by type, referenced hunk and original order */
+{
+  const struct hunkreloc *r1 = left;
+  const struct hunkreloc *r2 = right;
+
+  if (r1->hunk_id != r2->hunk_id)
+    return r1->hunk_id < r2->hunk_id ? -1 : 1;
+  if (r1->hunk_index != r2->hunk_index)
+    return r1->hunk_index < r2->hunk_index ? -1 : 1;
+  return r1->seq < r2->seq ? -1 : (r1->seq > r2->seq);
+}
+
+
+static int seqcmp(const void *left,const void *right)
 {
+  const struct hunkreloc *r1 = left;
+  const struct hunkreloc *r2 = right;
+
+  return r1->seq < r2->seq ? -1 : (r1->seq > r2->seq);
+}
+
+
+static void reloc_hunk(FILE *f,uint32_t type,int shrt,struct hunkrelocs *rels)
+/* write all section-offsets for one relocation type, rels must be sorted */
+{
+  struct hunkreloc *r = rels->r;
+  struct hunkreloc *end = r + rels->num;
+  struct hunkreloc *g;
   unsigned long bytes = 0;
+  unsigned long cnt,n;
   uint32_t idx;
 
-  for (idx=0; idx<sec_cnt; idx++) {
-    struct list myreloclist;
-    struct hunkreloc *r,*next;
-    unsigned long cnt,n;
-
-    /* move appropriate relocs into the list for this hunk */
-    initlist(&myreloclist);
-    cnt = 0;
-
-    r = (struct hunkreloc *)reloclist->first;
-    while (next = (struct hunkreloc *)r->n.next) {
-      if (r->hunk_id==type && r->hunk_index==idx &&
-          (!shrt || r->hunk_offset < 0x10000)) {
-        remnode(&r->n);
-        addtail(&myreloclist,&r->n);
+  while (r<end && r->hunk_id!=type)
+    r++;
+
+  for (; r<end && r->hunk_id==type && r->hunk_index<sec_cnt; r=g) {
+    /* count the unwritten relocs of this type for the referenced hunk */
+    idx = r->hunk_index;
+    for (g=r,cnt=0; g<end && g->hunk_id==type && g->hunk_index==idx; g++) {
+      if (g->rl!=NULL && (!shrt || g->hunk_offset < 0x10000))
         cnt++;
-      }
-      r = next;
     }
 
     if (cnt) {
@@ -609,35 +650,42 @@ static void reloc_hunk(FILE *f,uint32_t type,int shrt,struct list *reloclist)
           fw32(f,type,1);
         bytes = 4;
       }
+      hstat.relocs += cnt;
+      if (shrt)
+        hstat.shortrelocs += cnt;
 
-      if (shrt) {
-        /* output up to 65535 short relocs with unsigned 16-bit offsets */
-        while (n = cnt) {
+      while (n = cnt) {
+        if (shrt) {
+          /* output up to 65535 short relocs with unsigned 16-bit offsets */
           if (n > 0xffff)
             n = 0xffff;  /* maximum entries for short relocs */
           fw16(f,n,1);   /* number of relocations */
           fw16(f,idx,1); /* referenced section index */
-          cnt -= n;
-  
-          while (n-- && (r=(struct hunkreloc *)remhead(&myreloclist))) {
-            fw16(f,r->hunk_offset,1);
-            bytes += 2;
-            myfree(r);
-          }
+          bytes += 4;
         }
-      }
-      else {
-        /* output up to 65536 normal relocs with 32-bit offsets */
-        while (n = cnt) {
+        else {
+          /* output up to 65536 normal relocs with 32-bit offsets */
           if (exec_out && n>0x10000)
             n = 0x10000; /* limitation from AmigaDOS LoadSeg() */
           fw32(f,n,1);   /* number of relocations */
           fw32(f,idx,1); /* referenced section index */
-          cnt -= n;
-
-          while (n-- && (r=(struct hunkreloc *)remhead(&myreloclist))) {
-            fw32(f,r->hunk_offset,1);
-            myfree(r);
+          bytes += 8;
+        }
+        hstat.blocks++;
+        cnt -= n;
+
+        for (; n; r++) {
+          if (r->rl!=NULL && (!shrt || r->hunk_offset < 0x10000)) {
+            if (shrt) {
+              fw16(f,r->hunk_offset,1);
+              bytes += 2;
+            }
+            else {
+              fw32(f,r->hunk_offset,1);
+              bytes += 4;
+            }
+            r->rl = NULL;
+            n--;
           }
         }
       }
@@ -648,10 +696,13 @@ static void reloc_hunk(FILE *f,uint32_t type,int shrt,struct list *reloclist)
     /* no more relocation entries for this hunk - output terminating zero */
     if (shrt) {
       fw16(f,0,1);
+      hstat.bytes += bytes + 2 + balign(bytes+2,4);
       fwalign(f,bytes+2,4);
     }
-    else
+    else {
       fw32(f,0,1);
+      hstat.bytes += bytes + 4;
+    }
   }
 }
 
@@ -777,40 +828,64 @@ static void exttrailer(FILE *f)
 }
 
 
-static void ext_refs(FILE *f,struct list *xreflist)
+static int xrefnamecmp(const void *left,const void *right)
+/* sort by name, type and original order */
+{
+  const struct hunkxref *x1 = left;
+  const struct hunkxref *x2 = right;
+  int c;
+
+  if (x1->name!=x2->name && (c = strcmp(x1->name,x2->name)))
+    return c;  /* interned names are equal when the pointers are */
+  if (x1->type != x2->type)
+    return x1->type < x2->type ? -1 : 1;
+  return x1->seq < x2->seq ? -1 : (x1->seq > x2->seq);
+}
+
+
+static int xreffirstcmp(const void *left,const void *right)
+/* sort by first appearance of the name/type group and original order */
+{
+  const struct hunkxref *x1 = left;
+  const struct hunkxref *x2 = right;
+
+  if (x1->first != x2->first)
+    return x1->first < x2->first ? -1 : 1;
+  return x1->seq < x2->seq ? -1 : (x1->seq > x2->seq);
+}
+
+
+static void ext_refs(FILE *f,struct hunkxrefs *xrefs)
 /* write all external references from a section into a HUNK_EXT hunk */
 {
-  while (xreflist->first->next) {
-    struct hunkxref *x,*next;
-    uint32_t n,type,size;
-    const char *name;
-
-    extheader(f);
-    x = (struct hunkxref *)xreflist->first;
-    name = x->name;
-    type = x->type;
-    size = x->size;
-
-    for (n=0,x=(struct hunkxref *)xreflist->first;
-         x->n.next; x=(struct hunkxref *)x->n.next) {
-      if (!strcmp(x->name,name) && x->type==type)
-        n++;
-    }
-    fw32(f,(type<<24) | strlen32(name),1);
-    fwname(f,name);
-    if (type==EXT_ABSCOMMON || type==EXT_RELCOMMON)
-      fw32(f,size,1);
-    fw32(f,n,1);
+  struct hunkxref *x = xrefs->x;
+  struct hunkxref *end = x + xrefs->num;
+  struct hunkxref *g;
+  uint32_t n;
 
-    x = (struct hunkxref *)xreflist->first;
-    while (next = (struct hunkxref *)x->n.next) {
-      if (!strcmp(x->name,name) && x->type==type) {
-        fw32(f,x->offset,1);
-        remnode(&x->n);
-        myfree(x);
-      }
-      x = next;
-    } 
+  if (xrefs->num == 0)
+    return;
+
+  /* group references with the same name and type, in the order of
+     their first appearance */
+  qsort(x,xrefs->num,sizeof(struct hunkxref),xrefnamecmp);
+  for (g=x; g<end; g++)
+    g->first = (g>x && g[-1].type==g->type && g[-1].name==g->name) ?
+               g[-1].first : g->seq;
+  qsort(x,xrefs->num,sizeof(struct hunkxref),xreffirstcmp);
+
+  extheader(f);
+  for (; x<end; x=g) {
+    for (g=x,n=0; g<end && g->first==x->first; g++)
+      n++;
+    fw32(f,(x->type<<24) | strlen32(x->name),1);
+    fwname(f,x->name);
+    if (x->type==EXT_ABSCOMMON || x->type==EXT_RELCOMMON)
+      fw32(f,x->size,1);
+    fw32(f,n,1);
+    hstat.xrefs += n;
+    for (; x<g; x++)
+      fw32(f,x->offset,1);
   }
 }
 
@@ -865,14 +940,57 @@ static void ext_defs(FILE *f,int symtype,int global,size_t idx,
 }
 
 
-static void report_bad_relocs(struct list *reloclist)
+static void report_bad_relocs(struct hunkrelocs *rels)
 {
-  struct hunkreloc *r;
+  size_t i;
 
-  /* report all remaining relocs in the list as unsupported */
-  for (r=(struct hunkreloc *)reloclist->first; r->n.next;
-       r=(struct hunkreloc *)r->n.next)
-    unsupp_reloc_error(r->a,r->rl);  /* reloc not supported */
+  /* report all remaining relocs in their original order as unsupported */
+  for (i=0; i<rels->num; i++) {
+    if (rels->r[i].rl != NULL)
+      break;
+  }
+  if (i < rels->num) {
+    qsort(rels->r,rels->num,sizeof(struct hunkreloc),seqcmp);
+    for (i=0; i<rels->num; i++) {
+      if (rels->r[i].rl != NULL)
+        unsupp_reloc_error(rels->r[i].a,rels->r[i].rl);
+    }
+  }
+}
+
+
+static void hunkstats_start(void)
+{
+  memset(&hstat,0,sizeof(hstat));
+  memset(&hstat_total,0,sizeof(hstat_total));
+  if (hunkstats && !nostdout)
+    printf("\nhunk  name           type   relocs    short  blocks   xrefs"
+           "  rel.bytes\n");
+}
+
+
+static void hunkstats_line(section *sec,uint32_t type)
+/* print -hunkstats summary for one hunk and add it to the totals,
+   print the totals when sec is NULL */
+{
+  static const char *tname[] = { "code","data","bss" };
+
+  if (sec == NULL) {
+    hstat = hstat_total;
+    printf("total%21s",emptystr);
+  }
+  else {
+    printf("%4lu  %-14.14s %-4s ",(unsigned long)sec->idx,sec->name,
+           type>=HUNK_CODE && type<=HUNK_BSS ? tname[type-HUNK_CODE] : "ppc");
+    hstat_total.relocs += hstat.relocs;
+    hstat_total.shortrelocs += hstat.shortrelocs;
+    hstat_total.blocks += hstat.blocks;
+    hstat_total.xrefs += hstat.xrefs;
+    hstat_total.bytes += hstat.bytes;
+  }
+  printf("%8lu %8lu %7lu %7lu %10lu\n",hstat.relocs,hstat.shortrelocs,
+         hstat.blocks,hstat.xrefs,hstat.bytes);
+  memset(&hstat,0,sizeof(hstat));
 }
 
 
@@ -891,6 +1009,7 @@ static void write_object(FILE *f,section *sec,symbol *sym)
   int wrotesec = 0;
 
   sec = prepare_sections(sec,sym);
+  hunkstats_start();
 
   /* write header */
   fw32(f,HUNK_UNIT,1);
@@ -902,11 +1021,13 @@ static void write_object(FILE *f,section *sec,symbol *sym)
       if (!(sec->flags & SEC_DELETED)) {
         uint32_t type;
         atom *a;
-        struct list reloclist,xreflist,linedblist;
+        struct hunkrelocs rels;
+        struct hunkxrefs xrefs;
+        struct list linedblist;
 
         wrotesec = 1;
-        initlist(&reloclist);
-        initlist(&xreflist);
+        memset(&rels,0,sizeof(rels));
+        memset(&xrefs,0,sizeof(xrefs));
         initlist(&linedblist);
 
         /* section name */
@@ -941,7 +1062,7 @@ static void write_object(FILE *f,section *sec,symbol *sym)
             else if (a->type == LINE && !genlinedebug)
               add_linedebug(&linedblist,NULL,a->content.srcline,npc);
 
-            process_relocs(a,&reloclist,&xreflist,sec,npc);
+            process_relocs(a,&rels,&xrefs,sec,npc);
 
             pc = npc + atom_size(a,sec,npc);
           }
@@ -965,17 +1086,20 @@ static void write_object(FILE *f,section *sec,symbol *sym)
         }
 
         /* relocation hunks */
-        reloc_hunk(f,HUNK_ABSRELOC32,0,&reloclist);
-        reloc_hunk(f,HUNK_RELRELOC8,0,&reloclist);
-        reloc_hunk(f,HUNK_RELRELOC16,0,&reloclist);
-        reloc_hunk(f,HUNK_RELRELOC26,0,&reloclist);
-        reloc_hunk(f,HUNK_RELRELOC32,0,&reloclist);
-        reloc_hunk(f,HUNK_DREL16,0,&reloclist);
-        report_bad_relocs(&reloclist);
+        qsort(rels.r,rels.num,sizeof(struct hunkreloc),relcmp);
+        reloc_hunk(f,HUNK_ABSRELOC32,0,&rels);
+        reloc_hunk(f,HUNK_RELRELOC8,0,&rels);
+        reloc_hunk(f,HUNK_RELRELOC16,0,&rels);
+        reloc_hunk(f,HUNK_RELRELOC26,0,&rels);
+        reloc_hunk(f,HUNK_RELRELOC32,0,&rels);
+        reloc_hunk(f,HUNK_DREL16,0,&rels);
+        report_bad_relocs(&rels);
+        myfree(rels.r);
 
         /* external references and global definitions */
         exthunk = 0;
-        ext_refs(f,&xreflist);
+        ext_refs(f,&xrefs);
+        myfree(xrefs.x);
         if (sec->idx == 0)  /* absolute definitions into first hunk */
           ext_defs(f,EXPRESSION,EXPORT,0,EXT_ABS);
         ext_defs(f,LABSYM,EXPORT,sec->idx,EXT_DEF);
@@ -988,9 +1112,13 @@ static void write_object(FILE *f,section *sec,symbol *sym)
           linedebug_hunk(f,&linedblist);
         }
         fw32(f,HUNK_END,1);
+        if (hunkstats && !nostdout)
+          hunkstats_line(sec,type);
       }
     }
   }
+  if (hunkstats && wrotesec && !nostdout)
+    hunkstats_line(NULL,0);
   if (!wrotesec) {
     /* there was no section at all - dummy section size 0 */
 #if defined(VASM_CPU_PPC)
@@ -1009,6 +1137,7 @@ static void write_exec(FILE *f,section *sec,symbol *sym)
   section *s;
 
   sec = prepare_sections(sec,sym);
+  hunkstats_start();
 
   /* write header */
   fw32(f,HUNK_HEADER,1);
@@ -1030,9 +1159,10 @@ static void write_exec(FILE *f,section *sec,symbol *sym)
       if (!(sec->flags & SEC_DELETED)) {
       	uint32_t type;
         atom *a;
-        struct list reloclist,linedblist;
+        struct hunkrelocs rels;
+        struct list linedblist;
 
-        initlist(&reloclist);
+        memset(&rels,0,sizeof(rels));
         initlist(&linedblist);
 
         /* write hunk-type and size */
@@ -1061,7 +1191,7 @@ static void write_exec(FILE *f,section *sec,symbol *sym)
             else if (a->type==LINE && !genlinedebug)
               add_linedebug(&linedblist,NULL,a->content.srcline,npc);
 
-            process_relocs(a,&reloclist,NULL,sec,npc);
+            process_relocs(a,&rels,NULL,sec,npc);
 
             pc = npc + atom_size(a,sec,npc);
           }
@@ -1089,12 +1219,14 @@ static void write_exec(FILE *f,section *sec,symbol *sym)
           }
         }
 
+        qsort(rels.r,rels.num,sizeof(struct hunkreloc),relcmp);
         if (!kick1)
-          reloc_hunk(f,HUNK_ABSRELOC32,1,&reloclist);
-        reloc_hunk(f,HUNK_ABSRELOC32,0,&reloclist);
+          reloc_hunk(f,HUNK_ABSRELOC32,1,&rels);
+        reloc_hunk(f,HUNK_ABSRELOC32,0,&rels);
         if (!kick1)  /* RELRELOC32 works with short 16-bit offsets only! */
-          reloc_hunk(f,HUNK_RELRELOC32,1,&reloclist);
-        report_bad_relocs(&reloclist);
+          reloc_hunk(f,HUNK_RELRELOC32,1,&rels);
+        report_bad_relocs(&rels);
+        myfree(rels.r);
 
         if (!no_symbols) {
           /* symbol table */
@@ -1103,8 +1235,12 @@ static void write_exec(FILE *f,section *sec,symbol *sym)
           linedebug_hunk(f,&linedblist);
         }
         fw32(f,HUNK_END,1);
+        if (hunkstats && !nostdout)
+          hunkstats_line(sec,type);
       }
     }
+    if (hunkstats && !nostdout)
+      hunkstats_line(NULL,0);
   }
   else {
     /* no sections: create single code hunk with size 0 */
@@ -1148,6 +1284,10 @@ static int common_args(char *p)
     debug_symbols = DBGSYM_ULOCAL;
     return 1;
   }
+  if (!strcmp(p,"-hunkstats")) {
+    hunkstats = 1;
+    return 1;
+  }
   if (!strcmp(p,"-noabspath")) {
     noabspath = 1;
     return 1;
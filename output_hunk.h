@@ -3,22 +3,36 @@
 
 /* hunk-format relocs */
 struct hunkreloc {
-  struct node n;
   atom *a;
-  rlist *rl;
+  rlist *rl;  /* NULL after the relocation was written */
   uint32_t hunk_id;
   uint32_t hunk_index;
   uint32_t hunk_offset;
+  uint32_t seq;
 };
 
 /* hunk-format external reference */
 struct hunkxref {
-  struct node n;
   const char *name;
   uint32_t type;
   uint32_t size;
   uint32_t offset;
+  uint32_t seq;
+  uint32_t first;  /* seq of first reference with same name and type */
+};
+
+/* relocations and external references of a section, sorted before output */
+struct hunkrelocs {
+  struct hunkreloc *r;
+  size_t num;
+  size_t size;
+};
+struct hunkxrefs {
+  struct hunkxref *x;
+  size_t num;
+  size_t size;
 };
+#define HUNKRELOCINC 256
 
 /* line debug hunk */
 struct linedb_block {
@@ -532,6 +532,7 @@ static void o65_writeglobals(FILE *f,symbol *sym)
 static void write_output(FILE *f,section *sec,symbol *sym)
 {
   importhash = new_hashtable(IMPHTABSIZE);
+  importhash->name = "o65 imports";
   o65_initwrite(sec);
   o65_header(f);
   o65_writesection(f,sections[S_TEXT]);
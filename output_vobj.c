@@ -65,13 +65,55 @@ special
     .byte 192-255 [x-0xC0 bytes little-endian], fill remaining with 0xff [vobj version 2+]
 */
 
-static void write_number(FILE *f,taddr val)
+/* numbers and strings are encoded into a buffer, which is written in one go */
+struct vbuf {
+  unsigned char *data;
+  size_t len,size;
+  size_t nspec;  /* special cpu relocations, written directly to the file */
+  struct vspec { size_t pos; rlist *rl; } *spec;
+};
+#define VBUFINC 0x1000
+
+static struct vbuf hdrbuf,relbuf;
+
+static unsigned char *vbuf_room(struct vbuf *b,size_t n)
+{
+  unsigned char *p;
+
+  if(b->len+n>b->size){
+    do
+      b->size=b->size?b->size*2:VBUFINC;
+    while(b->len+n>b->size);
+    b->data=myrealloc(b->data,b->size);
+  }
+  p=b->data+b->len;
+  b->len+=n;
+  return p;
+}
+
+static void vbuf_flush(FILE *f,struct vbuf *b)
+{
+  size_t i,pos;
+
+  for(i=pos=0;i<b->nspec;i++){
+    fwdata(f,b->data+pos,b->spec[i].pos-pos);
+#ifdef LAST_CPU_RELOC
+    cpu_reloc_write(f,b->spec[i].rl);
+#endif
+    pos=b->spec[i].pos;
+  }
+  fwdata(f,b->data+pos,b->len-pos);
+  b->len=b->nspec=0;
+}
+
+static void write_number(struct vbuf *b,taddr val)
 {
   int i,s,u;
+  unsigned char *p;
   taddr tmp;
 
   if(val>=0&&val<=127){
-    fw8(f,val);
+    *vbuf_room(b,1)=val;
     return;
   }
   
@@ -86,24 +128,25 @@ static void write_number(FILE *f,taddr val)
   }
 
   if(u<s){
-    fw8(f,0xC0+u);
+    p=vbuf_room(b,u+1);
+    *p++=0xC0+u;
     s=u;
-  }else
-    fw8(f,0x80+s);
+  }else{
+    p=vbuf_room(b,s+1);
+    *p++=0x80+s;
+  }
 
   for(i=s;i>0;i--){
-    fw8(f,val&0xff);
+    *p++=val&0xff;
     val>>=8;
   }
 }
 
-static void write_string(FILE *f,const char *p)
+static void write_string(struct vbuf *b,const char *p)
 {
-  while(p&&*p){
-    fw8(f,*p);
-    p++;
-  }
-  fw8(f,0);
+  size_t len=p?strlen(p)+1:1;
+
+  memcpy(vbuf_room(b,len),p?p:"",len);
 }
 
 static int sym_valid(symbol *symp)
@@ -118,22 +161,51 @@ static int sym_valid(symbol *symp)
   return 1;
 }
 
-static int count_relocs(atom *p,rlist *rl)
+static int get_nreloc_sym_idx(nreloc *rel)
 {
-  int nrelocs;
+  int idx;
 
-  for(nrelocs=0; rl; rl=rl->next) {
+  if(!(idx=rel->sym->idx)){
+    if(rel->sym->type==IMPORT&&!sym_valid(rel->sym))
+      return 0;
+    idx=rel->sym->sec->idx;  /* symbol does not exist, use section-symbol */
+  }
+  return idx;
+}
+
+static int write_rlist(struct vbuf *b,atom *p,taddr pc,rlist *rl)
+/* encode the relocations of an atom at pc, return their number */
+{
+  int nrelocs,idx;
 
+  for(nrelocs=0;rl;rl=rl->next){
     if(is_nreloc(rl)){
-      nreloc *r = (nreloc *)rl->reloc;
-      if(r->sym->type==IMPORT&&!sym_valid(r->sym))
+      nreloc *rel=rl->reloc;
+      if(!(idx=get_nreloc_sym_idx(rel)))
         goto badreloc;
-      else
-        nrelocs++;
+      write_number(b,rl->type);
+      if(rl->type>=FIRST_CPU_RELOC)
+        write_number(b,0);  /* cpu-specific reloc is in nreloc format */
+      write_number(b,pc+rel->byteoffset);
+      write_number(b,rel->bitoffset);
+      write_number(b,rel->size);
+      write_number(b,rel->mask);
+      write_number(b,rel->addend);
+      write_number(b,idx);
+      nrelocs++;
     }
 #ifdef LAST_CPU_RELOC
     else if(rl->type>=FIRST_CPU_RELOC&&rl->type<=LAST_CPU_RELOC){
-      nrelocs+=cpu_reloc_size(rl)!=0;
+      size_t sz;
+
+      if(sz=cpu_reloc_size(rl)){
+        write_number(b,rl->type);
+        write_number(b,sz);
+        b->spec=myrealloc(b->spec,(b->nspec+1)*sizeof(struct vspec));
+        b->spec[b->nspec].pos=b->len;
+        b->spec[b->nspec++].rl=rl;
+        nrelocs++;
+      }
     }
 #endif
     else{
@@ -145,6 +217,7 @@ static int count_relocs(atom *p,rlist *rl)
 }
 
 static void get_section_sizes(section *sec,taddr *rsize,taddr *rdata,taddr *rnrelocs)
+/* determine sizes and encode all relocations of a section into relbuf */
 {
   taddr data=0,nrelocs=0;
   atom *p;
@@ -153,14 +226,15 @@ static void get_section_sizes(section *sec,taddr *rsize,taddr *rdata,taddr *rnre
   sec->pc=0;
   for(p=sec->first;p;p=p->next){
     sec->pc=pcalign(p,sec->pc);
-    sec->pc+=atom_size(p,sec,sec->pc);
     if(p->type==DATA){
+      nrelocs+=write_rlist(&relbuf,p,sec->pc,p->content.db->relocs);
+      sec->pc+=atom_size(p,sec,sec->pc);
       data=sec->pc;
-      nrelocs+=count_relocs(p,p->content.db->relocs);
     }
     else if(p->type==SPACE){
+      nrelocs+=write_rlist(&relbuf,p,sec->pc,p->content.sb->relocs);
+      sec->pc+=atom_size(p,sec,sec->pc);
       if(p->content.sb->relocs){
-        nrelocs+=count_relocs(p,p->content.sb->relocs);
         data=sec->pc;
       }else{
         for(i=0;i<OCTETS(p->content.sb->size);i++)
@@ -168,6 +242,8 @@ static void get_section_sizes(section *sec,taddr *rsize,taddr *rdata,taddr *rnre
             data=sec->pc;
       }
     }
+    else
+      sec->pc+=atom_size(p,sec,sec->pc);
   }
   *rdata=data;
   *rsize=sec->pc;
@@ -190,65 +266,6 @@ static void write_data(FILE *f,section *sec,utaddr data)
   }
 }
 
-static int get_nreloc_sym_idx(nreloc *rel)
-{
-  int idx;
-
-  if(!(idx=rel->sym->idx)){
-    if(rel->sym->type==IMPORT&&!sym_valid(rel->sym))
-      return 0;
-    idx=rel->sym->sec->idx;  /* symbol does not exist, use section-symbol */
-  }
-  return idx;
-}
-
-static void write_rlist(FILE *f,section *sec,rlist *rl)
-{
-  int idx;
-  for(;rl;rl=rl->next){
-    write_number(f,rl->type);
-    if(is_nreloc(rl)){
-      nreloc *rel=rl->reloc;
-      if (!(idx=get_nreloc_sym_idx(rel)))
-        continue;
-      if (rl->type>=FIRST_CPU_RELOC)
-        write_number(f,0);  /* cpu-specific reloc is in nreloc format */
-      write_number(f,sec->pc+rel->byteoffset);
-      write_number(f,rel->bitoffset);
-      write_number(f,rel->size);
-      write_number(f,rel->mask);
-      write_number(f,rel->addend);
-      write_number(f,idx);
-    }
-#ifdef LAST_CPU_RELOC
-    else if(rl->type>=FIRST_CPU_RELOC&&rl->type<=LAST_CPU_RELOC){
-      size_t sz;
-
-      if (sz=cpu_reloc_size(rl)){
-        write_number(f,sz);
-        cpu_reloc_write(f,rl);
-      }
-    }
-#endif
-    else
-      ierror(0);
-  }
-}
-
-static void write_relocs(FILE *f,section *sec)
-{
-  atom *p;
-  sec->pc=0;
-  for(p=sec->first;p;p=p->next){
-    sec->pc=pcalign(p,sec->pc);
-    if(p->type==DATA)
-      write_rlist(f,sec,p->content.db->relocs);
-    else if(p->type==SPACE)
-      write_rlist(f,sec,p->content.sb->relocs);
-    sec->pc+=atom_size(p,sec,sec->pc);
-  }
-}
-
 static void write_output(FILE *f,section *sec,symbol *sym)
 {
   int nsyms,nsecs;
@@ -285,56 +302,58 @@ static void write_output(FILE *f,section *sec,symbol *sym)
       symp->idx=0;  /* use section-symbol, when needed */
   }
 
-  fw32(f,0x564f424a,1); /* "VOBJ" */
+  memcpy(vbuf_room(&hdrbuf,4),"VOBJ",4);
   if(BIGENDIAN)
-    fw8(f,1|version);
+    *vbuf_room(&hdrbuf,1)=1|version;
   else if(LITTLEENDIAN)
-    fw8(f,2|version);
+    *vbuf_room(&hdrbuf,1)=2|version;
   else
     ierror(0);
-  write_number(f,BITSPERBYTE);
-  write_number(f,bytespertaddr);
-  write_string(f,cpuname);
-  write_number(f,nsecs-1);
-  write_number(f,nsyms-1);
+  write_number(&hdrbuf,BITSPERBYTE);
+  write_number(&hdrbuf,bytespertaddr);
+  write_string(&hdrbuf,cpuname);
+  write_number(&hdrbuf,nsecs-1);
+  write_number(&hdrbuf,nsyms-1);
 
   for(symp=first;symp;symp=symp->next){
     if(!sym_valid(symp))
       continue;
-    write_string(f,symp->name);
-    write_number(f,symp->type);
-    write_number(f,symp->flags);
+    write_string(&hdrbuf,symp->name);
+    write_number(&hdrbuf,symp->type);
+    write_number(&hdrbuf,symp->flags);
     if(symp->type==EXPRESSION&&symp->flags&SYMINDIR){
       symbol *indir;
       if(version<VOBJ3)
         output_error(25,"-vobj3","indirect symbols");  /* requires -vobj3 */
       if(find_base(symp->expr,&indir,NULL,0)!=BASE_OK)
         ierror(0);
-      write_number(f,0);
-      write_number(f,get_sym_value(symp));  /* @@@ possible indirect-addend */
-      write_number(f,indir->idx);  /* store index of indirect symbol as size */
+      write_number(&hdrbuf,0);
+      write_number(&hdrbuf,get_sym_value(symp));  /* @@@ possible indirect-addend */
+      write_number(&hdrbuf,indir->idx);  /* store index of indirect symbol as size */
     }
     else{
-      write_number(f,symp->sec?symp->sec->idx:0);
-      write_number(f,get_sym_value(symp));
-      write_number(f,get_sym_size(symp));
+      write_number(&hdrbuf,symp->sec?symp->sec->idx:0);
+      write_number(&hdrbuf,get_sym_value(symp));
+      write_number(&hdrbuf,get_sym_size(symp));
     }
   }
 
   for(secp=sec;secp;secp=secp->next){
-    write_string(f,secp->name);
-    write_string(f,secp->attr);
-    write_number(f,secp->flags);
+    write_string(&hdrbuf,secp->name);
+    write_string(&hdrbuf,secp->attr);
+    write_number(&hdrbuf,secp->flags);
     if(version>=VOBJ3&&(secp->flags&ABSOLUTE))
-      write_number(f,0);  /* @@@ FIXME! NOW! @@@ */
-    write_number(f,secp->align);
+      write_number(&hdrbuf,0);  /* @@@ FIXME! NOW! @@@ */
+    write_number(&hdrbuf,secp->align);
     get_section_sizes(secp,&size,&data,&nrelocs);
-    write_number(f,size);
-    write_number(f,nrelocs);
-    write_number(f,data);
+    write_number(&hdrbuf,size);
+    write_number(&hdrbuf,nrelocs);
+    write_number(&hdrbuf,data);
+    vbuf_flush(f,&hdrbuf);
     write_data(f,secp,(utaddr)data);
-    write_relocs(f,secp);
+    vbuf_flush(f,&relbuf);
   }
+  vbuf_flush(f,&hdrbuf);
 }
 
 static int output_args(char *p)
@@ -8,6 +8,7 @@ int nocase_macros;      /* macro names are case-insensitive */
 int maxmacparams = MAXMACPARAMS;
 int maxmacrecurs = MAXMACRECURS;
 int msource_disable;    /* true: disable source level debugging within macro */
+unsigned long macro_calls;  /* number of macro expansions */
 
 #ifndef MACROHTABSIZE
 #define MACROHTABSIZE 0x800
@@ -19,10 +20,24 @@ static hashtable *macrohash;
 #endif
 static hashtable *structhash;
 
+#ifndef IDCLASSHTABSIZE
+#define IDCLASSHTABSIZE 0x1000
+#endif
+static hashtable *idclasshash;
+struct idclass {
+  int flags;                    /* IDC_DIRECTIVE, IDC_MACRO, IDC_STRUCT */
+  int dir_idx;                  /* directive index with IDC_DIRECTIVE */
+};
+static const char *idc_name;    /* identifier classified last in this line */
+static int idc_len,idc_flags,idc_dir;
+
 static macro *first_macro;
 static macro *cur_macro;
 static struct namelen *enddir_list;
 static size_t enddir_minlen;
+static char defscan_stop[256];  /* definition scanner: characters to check */
+#define DEFSCAN_CHECK 1         /* string, comment or line end possible */
+#define DEFSCAN_DIR   2         /* may also start a directive */
 static struct namelen *macrdir_list;
 static struct namelen *reptdir_list;
 
@@ -34,6 +49,25 @@ static char *rept_start,*rept_name,*rept_vals;
 static section *cur_struct;
 static section *struct_prevsect;
 
+/* A repetition with a plain count is watched during its first iterations.
+   When parsing an iteration had no effect besides appending atoms to the
+   current section, without referring to the counter or the current pc,
+   then the remaining iterations would produce the same atoms again. They
+   are replayed by copying those atoms, instead of parsing the body.
+   A repetition before the first section is watched from its second
+   iteration on, which runs in the default section. */
+#define REPLAY_TRIES 2
+static struct {
+  source *src;
+  int tries;
+  section *sec;
+  atom *last;
+  unsigned long atoms,symupd,srcs,pcrefs;
+  int errors,warnings,clev;
+  symbol *cnt[2];
+  uint32_t cntused[2];
+} rwatch;
+
 
 char *escape(char *s,char *code)
 {
@@ -484,6 +518,39 @@ static size_t dirlist_minlen(struct namelen *list)
 }
 
 
+static void defscan_dirlist(struct namelen *list)
+{
+  if (list != NULL) {
+    for (; list->len; list++) {
+      defscan_stop[tolower((unsigned char)list->name[0])] = DEFSCAN_DIR;
+      defscan_stop[toupper((unsigned char)list->name[0])] = DEFSCAN_DIR;
+    }
+  }
+}
+
+
+/* Set up the characters, where the scanner for a macro or repeat definition
+   has to look for directives, strings, comments and line ends. Other
+   letters, digits and underscores are skipped, as no listed directive
+   can start with them. */
+static void init_defscan(void)
+{
+  int c;
+
+  for (c=0; c<256; c++)
+    defscan_stop[c] = !isalnum(c) && c!='_' ? DEFSCAN_CHECK : 0;
+  defscan_stop[(unsigned char)commentchar] = DEFSCAN_CHECK;
+  defscan_stop['.'] = DEFSCAN_DIR;  /* directives with optional dot */
+  defscan_dirlist(enddir_list);
+  if (cur_macro == NULL)
+    defscan_dirlist(reptdir_list);
+#ifdef MACRO_IN_MACRO_CHECK
+  else
+    defscan_dirlist(macrdir_list);
+#endif
+}
+
+
 /* add a skipped macro/repeat line to the listing */
 static void list_skipped_line(char *p)
 {
@@ -523,6 +590,7 @@ void new_repeat(int rcnt,char *name,char *vals,
     enddir_list = endrlist;
     enddir_minlen = dirlist_minlen(endrlist);
     reptdir_list = reptlist;
+    init_defscan();
     rept_start = cur_src->srcptr;
     rept_name = name ? mystrdup(name) : NULL;
     rept_vals = vals;
@@ -615,9 +683,14 @@ macro *new_macro(char *name,struct namelen *maclist,struct namelen *endmlist,
       rem_hashentry(macrohash,name,nocase_macros);
     }
     m = mymalloc(sizeof(macro));
-    m->name = mystrdup(name);
-    if (nocase_macros)
-      strtolower(m->name);
+    if (nocase_macros) {
+      char *lname = mystrdup(name);
+
+      m->name = intern_name(strtolower(lname));
+      myfree(lname);
+    }
+    else
+      m->name = intern_name(name);
     m->num_argnames = -1;
     m->argnames = m->defaults = NULL;
     m->recursions = 0;
@@ -656,6 +729,7 @@ macro *new_macro(char *name,struct namelen *maclist,struct namelen *endmlist,
     enddir_list = endmlist;
     enddir_minlen = dirlist_minlen(endmlist);
     macrdir_list = maclist;
+    init_defscan();
     rept_cnt = -1;
     rept_start = NULL;
 
@@ -745,6 +819,7 @@ int execute_macro(char *name,int name_len,char **q,int *q_len,int nq,
     return 0;
   }
   m->recursions++;
+  macro_calls++;
 
   src = new_source(m->name,NULL,m->text,m->size);
   src->macro = m;
@@ -885,6 +960,175 @@ int undef_macro(char *name)
 }
 
 
+/* Add a class to the case-insensitive table of statement identifiers,
+   which allows the syntax module to find out with a single lookup whether
+   a name may be a directive, a macro or a structure. A class is never
+   removed, so it only tells where a name might be found. */
+void add_idclass(const char *name,int cls,int dir_idx)
+{
+  struct idclass *ic;
+  hashdata data;
+
+  if (find_name_nc(idclasshash,name,&data))
+    ic = data.ptr;
+  else {
+    ic = mymalloc(sizeof(struct idclass));
+    ic->flags = 0;
+    ic->dir_idx = -1;
+    data.ptr = ic;
+    add_hashentry(idclasshash,name,data,1);
+  }
+  ic->flags |= cls;
+  if (cls & IDC_DIRECTIVE)
+    ic->dir_idx = dir_idx;
+  idc_name = NULL;
+}
+
+
+/* Return the classes of an identifier and its directive index, if any.
+   The result for the same identifier in the current line is reused, so
+   the syntax module may check it against all its tables without another
+   lookup. */
+int find_idclass(const char *name,int name_len,int *dir_idx)
+{
+  hashdata data;
+
+  if (name!=idc_name || name_len!=idc_len) {
+    if (find_namelen_nc(idclasshash,name,name_len,&data)) {
+      struct idclass *ic = data.ptr;
+
+      idc_flags = ic->flags;
+      idc_dir = ic->dir_idx;
+    }
+    else {
+      idc_flags = 0;
+      idc_dir = -1;
+    }
+    idc_name = name;
+    idc_len = name_len;
+  }
+  if (dir_idx)
+    *dir_idx = idc_dir;
+  return idc_flags;
+}
+
+
+static void end_watch(void)
+{
+  int i;
+
+  if (rwatch.src != NULL) {
+    for (i=0; i<2; i++) {
+      if (rwatch.cnt[i] != NULL)
+        rwatch.cnt[i]->flags |= rwatch.cntused[i];
+    }
+    rwatch.src = NULL;
+  }
+}
+
+
+static void watch_repeat(source *src,int tries)
+{
+  symbol *sym;
+  int i;
+
+  end_watch();
+  if (listena)
+    return;
+  end_merged_data();  /* the iteration must begin with a new atom */
+
+  rwatch.cnt[0] = src->reptcntname ? find_symbol(src->reptcntname) : NULL;
+#ifdef REPTNSYM
+  rwatch.cnt[1] = find_symbol(REPTNSYM);
+#else
+  rwatch.cnt[1] = NULL;
+#endif
+  for (i=0; i<2; i++) {
+    if ((sym = rwatch.cnt[i]) != NULL) {
+      /* any reference to the counter sets USED again */
+      rwatch.cntused[i] = sym->flags & USED;
+      sym->flags &= ~USED;
+    }
+  }
+  rwatch.src = src;
+  rwatch.tries = tries;
+  rwatch.sec = current_section;
+  rwatch.last = current_section!=NULL ? current_section->last : NULL;
+  rwatch.atoms = atoms_added;
+  rwatch.symupd = symbol_updates();
+  rwatch.srcs = src_count;
+  rwatch.pcrefs = curpc_refs;
+  rwatch.errors = errors;
+  rwatch.warnings = warnings;
+  rwatch.clev = clev;
+}
+
+
+/* Called at the end of a watched iteration of cur_src. Replays the
+   remaining iterations, when possible. Returns true when the next
+   iteration should be watched instead. */
+static int replay_repeat(void)
+{
+  section *sec = rwatch.sec;
+  unsigned long n;
+  atom *first,*last,*a,*new;
+  int i,used=0;
+
+  for (i=0; i<2; i++) {
+    if (rwatch.cnt[i]!=NULL && (rwatch.cnt[i]->flags & USED))
+      used = 1;
+  }
+  end_watch();
+  if (cur_src->repeat <= 1)
+    return 0;
+  if (sec == NULL)
+    return 1;  /* started before the first section, watch the next one */
+
+  if (used || listena || current_section!=sec ||
+      symbol_updates()!=rwatch.symupd || src_count!=rwatch.srcs ||
+      curpc_refs!=rwatch.pcrefs || errors!=rwatch.errors ||
+      warnings!=rwatch.warnings || clev!=rwatch.clev)
+    return --rwatch.tries > 0;
+
+  /* all new atoms must be from this iteration and in the current section */
+  first = rwatch.last!=NULL ? rwatch.last->next : sec->first;
+  last = sec->last;
+  for (a=first,n=0; a!=NULL; a=a->next,n++) {
+    if (!replicable_atom(a))
+      return --rwatch.tries > 0;
+  }
+  if (n != atoms_added-rwatch.atoms)
+    return --rwatch.tries > 0;
+
+  hot_stats[HS_REPT_REPLAYS] += cur_src->repeat - 1;
+  if (n != 0) {
+    while (cur_src->repeat > 1) {
+      for (a=first; ; a=a->next) {
+        add_atom(sec,new=replicate_atom(a));
+        new->src = a->src;
+        new->line = a->line;
+        if (a == last)
+          break;
+      }
+      cur_src->repeat--;
+      cur_src->reptn++;
+    }
+  }
+  else {
+    cur_src->reptn += cur_src->repeat - 1;
+    cur_src->repeat = 1;
+  }
+
+  /* leave the counters with their final values */
+  if (cur_src->reptcntname != NULL)
+    new_abs(cur_src->reptcntname,number_expr(cur_src->reptn));
+#ifdef REPTNSYM
+  set_internal_abs(REPTNSYM,cur_src->reptn);
+#endif
+  return 0;
+}
+
+
 static void start_repeat(char *rept_end)
 {
   char buf[MAXPATHLEN];
@@ -985,6 +1229,37 @@ static void start_repeat(char *rept_end)
     if (src->repeat == 0)
       ierror(0);
     cur_src = src;  /* repeat it */
+    if (rept_cnt > 1)
+      watch_repeat(src,REPLAY_TRIES);
+  }
+}
+
+
+/* make a complete macro definition known */
+void define_macro(macro *m)
+{
+  hashdata data;
+
+  m->next = first_macro;
+  first_macro = m;
+  data.ptr = m;
+  if (nocase_macros)
+    add_hashentry(macrohash,m->name,data,1);
+  else
+    add_hashentry_hc(macrohash,m->name,interned_hash(m->name),data);
+  add_idclass(m->name,IDC_MACRO,0);
+}
+
+
+/* call fn for every macro, which is currently defined */
+void walk_macros(void (*fn)(macro *,void *),void *arg)
+{
+  macro *m;
+
+  for (m=first_macro; m!=NULL; m=m->next) {
+    /* skip old definitions, which were replaced or removed */
+    if (find_macro((char *)m->name,strlen(m->name)) == m)
+      fn(m,arg);
   }
 }
 
@@ -993,13 +1268,8 @@ static void add_macro(void)
 {
   if (cur_macro!=NULL && cur_src!=NULL) {
     if (cur_macro->text != NULL) {
-      hashdata data;
-
       cur_macro->size = cur_src->srcptr - cur_macro->text;
-      cur_macro->next = first_macro;
-      first_macro = cur_macro;
-      data.ptr = cur_macro;
-      add_hashentry(macrohash,cur_macro->name,data,nocase_macros);
+      define_macro(cur_macro);
     }
     cur_macro = NULL;
   }
@@ -1057,6 +1327,7 @@ int new_structure(char *name)
   switch_offset_section(name,-1);
   data.ptr = cur_struct = current_section;
   add_hashentry(structhash,cur_struct->name,data,nocase_macros);
+  add_idclass(cur_struct->name,IDC_STRUCT,0);
   return 1;
 }
 
@@ -1098,12 +1369,16 @@ char *read_next_line(void)
   char *s,*srcend,*d;
   int nparam,len;
   int skip_listing = 0;
+  int rewatch;
   char *rept_end = NULL;
 
+  idc_name = NULL;  /* new line, forget the last identifier class */
+
   /* check if end of source is reached */
   for (;;) {
     srcend = cur_src->text + cur_src->size;
     if (cur_src->srcptr >= srcend || *(cur_src->srcptr) == '\0') {
+      rewatch = cur_src==rwatch.src ? replay_repeat() : 0;
       if (--cur_src->repeat > 0) {
         struct macarg *irpval;
 
@@ -1120,6 +1395,8 @@ char *read_next_line(void)
 #ifdef REPTNSYM
         set_internal_abs(REPTNSYM,cur_src->reptn);
 #endif
+        if (rewatch)
+          watch_repeat(cur_src,rwatch.tries);
       }
       else {
         if (cur_src->macro != NULL) {
@@ -1165,30 +1442,38 @@ char *read_next_line(void)
         general_error(26,cur_src->name);  /* macro definition inside macro */
 
     while (s <= (srcend-enddir_minlen)) {
-      if (dir = dirlist_match(s,srcend,enddir_list)) {
-        if (cur_macro != NULL) {
-          add_macro();  /* link macro-definition into hash-table */
-          enddir_list = NULL;
-          break;
+      int scan = defscan_stop[(unsigned char)*s];
+
+      if (!scan) {
+        s++;  /* cannot start a directive, string, comment or new line */
+        continue;
+      }
+      if (scan == DEFSCAN_DIR) {
+        if (dir = dirlist_match(s,srcend,enddir_list)) {
+          if (cur_macro != NULL) {
+            add_macro();  /* link macro-definition into hash-table */
+            enddir_list = NULL;
+            break;
+          }
+          else if (--rept_nest == 0) {
+            rept_end = s;
+            enddir_list = NULL;
+            break;
+          }
+          s += dir->len;
         }
-        else if (--rept_nest == 0) {
-          rept_end = s;
-          enddir_list = NULL;
-          break;
+        else if (cur_macro==NULL && reptdir_list!=NULL &&
+                 (dir = dirlist_match(s,srcend,reptdir_list)) != NULL) {
+          s += dir->len;
+          rept_nest++;
         }
-        s += dir->len;
-      }
-      else if (cur_macro==NULL && reptdir_list!=NULL &&
-               (dir = dirlist_match(s,srcend,reptdir_list)) != NULL) {
-        s += dir->len;
-        rept_nest++;
-      }
 #ifdef MACRO_IN_MACRO_CHECK  /* caution: misdetection in operands possible */
-      else if (cur_macro!=NULL &&
-               (dir = dirlist_match(s,srcend,macrdir_list)) != NULL) {
-        general_error(26,cur_macro->name);  /* macro definition inside macro */
-      }
+        else if (cur_macro!=NULL &&
+                 (dir = dirlist_match(s,srcend,macrdir_list)) != NULL) {
+          general_error(26,cur_macro->name);  /* macro definition inside macro */
+        }
 #endif
+      }
 
       if (*s=='\"' || *s=='\'') {
         char c = *s++;
@@ -1306,6 +1591,10 @@ char *read_next_line(void)
 int init_parse(void)
 {
   macrohash = new_hashtable(MACROHTABSIZE);
+  macrohash->name = "macros";
   structhash = new_hashtable(STRUCTHTABSIZE);
+  structhash->name = "structures";
+  idclasshash = new_hashtable(IDCLASSHTABSIZE);
+  idclasshash->name = "identifier classes";
   return 1;
 }
@@ -23,7 +23,7 @@ struct macarg {
 
 struct macro {
   struct macro *next;
-  char *name;
+  const char *name;
   char *text;
   size_t size;
   source *defsrc;
@@ -45,6 +45,7 @@ struct namelen {
 extern int esc_sequences,nocase_macros;
 extern int maxmacparams,maxmacrecurs;
 extern int msource_disable;
+extern unsigned long macro_calls;
 
 /* functions */
 char *escape(char *,char *);
@@ -67,6 +68,8 @@ int find_macarg_name(source *,char *,size_t);
 struct macarg *addmacarg(struct macarg **,char *,char *);
 macro *new_macro(char *,struct namelen *,struct namelen *,char *);
 macro *find_macro(char *,int);
+void define_macro(macro *);
+void walk_macros(void (*)(macro *,void *),void *);
 int execute_macro(char *,int,char **,int *,int,char *);
 int leave_macro(void);
 int undef_macro(char *);
@@ -75,6 +78,8 @@ int copy_macro_qual(source *,int,char *,int);
 int new_structure(char *);
 int end_structure(section **);
 section *find_structure(char *,int);
+void add_idclass(const char *,int,int);
+int find_idclass(const char *,int,int *);
 char *read_next_line(void);
 int init_parse(void);
 
@@ -82,6 +87,11 @@ int init_parse(void);
 #define REPT_IRP -100           /* repetition with a list of values */
 #define REPT_IRPC -101          /* repetition with a list of characters */
 
+/* classes of a statement identifier, as returned by find_idclass() */
+#define IDC_DIRECTIVE 1
+#define IDC_MACRO     2
+#define IDC_STRUCT    4
+
 /* find_macarg_name(), copy_macro_param() for current REPT iterator value */
 #define IRPVAL 10000
 
@@ -0,0 +1,494 @@
+/* pch.c - precompiled headers */
+/* (c) 2025 Bryan Woodruff, Cortexa LLC */
+
+#include "vasm.h"
+#include "pch.h"
+
+/* A precompiled header image starts with an id, a version and the hash
+   code of the options. Then follow records, each starting with a type
+   byte: the source files of the headers, with size and hash code of
+   their text, symbols, register symbols, macros and the state of the
+   syntax module. All numbers are
+   32-bit big-endian. Strings are stored with their length and a
+   terminating nul-byte, so the image can be used in place after
+   loading it with a single read. */
+
+#define PCH_VERSION 2
+
+#define PCH_END     0
+#define PCH_FILE    'F'
+#define PCH_SYMBOL  'S'
+#define PCH_REGSYM  'R'
+#define PCH_MACRO   'M'
+#define PCH_SYNTAX  'X'
+
+static const char pch_id[4] = { 'V','P','C','H' };
+static uint32_t options_hash;
+
+struct pch_reader {
+  uint8_t *p;
+  uint8_t *end;
+  int bad;
+};
+
+
+static uint32_t str_hash(uint32_t h,const char *s)
+{
+  do {
+    h ^= (uint8_t)*s;  /* FNV-1a, including the nul-byte as separator */
+    h *= 16777619UL;
+  } while (*s++);
+  return h;
+}
+
+
+/* Remember a hash code of the assembler version and of all options, which
+   may change the way the headers are parsed. Names of input and output
+   files and the options for reports are not included. */
+void pch_options(int argc,char **argv)
+{
+  static const char *fileopts[] = {  /* followed by a file name */
+    "-o","-L","-depfile","-symbols",NULL
+  };
+  static const char *reportopts[] = {
+    "-pch-","-L","-depend","-timing","-stats","-resolve-stats",
+    "-maxerrors=","-jobs=",NULL
+  };
+  uint32_t h = 2166136261UL;
+  int i,j;
+
+  h = str_hash(h,vasmname);
+  h = str_hash(h,cpu_copyright);
+  h = str_hash(h,syntax_copyright);
+
+  for (i=1; i<argc; i++) {
+    if (argv[i][0] != '-')
+      continue;  /* input name, or an option already processed by main() */
+    for (j=0; fileopts[j]!=NULL && strcmp(argv[i],fileopts[j]); j++);
+    if (fileopts[j] != NULL) {
+      i++;
+      continue;
+    }
+    for (j=0; reportopts[j]!=NULL &&
+              strncmp(argv[i],reportopts[j],strlen(reportopts[j])); j++);
+    if (reportopts[j] != NULL)
+      continue;
+    h = str_hash(h,argv[i]);
+    if ((!strcmp(argv[i],"-D") || !strcmp(argv[i],"-I")) && i<argc-1)
+      h = str_hash(h,argv[++i]);
+  }
+  options_hash = h;
+}
+
+
+static void put32(FILE *f,uint32_t v)
+{
+  fw32(f,v,1);
+}
+
+
+static void putstr(FILE *f,const char *s,size_t len)
+{
+  put32(f,len);
+  fwdata(f,s,len);
+  fw8(f,0);
+}
+
+
+static void putarg(FILE *f,struct macarg *ma)
+{
+  if (ma->arglen == MACARG_REQUIRED) {
+    put32(f,1);
+    putstr(f,emptystr,0);
+  }
+  else {
+    put32(f,0);
+    putstr(f,ma->argname,ma->arglen);
+  }
+}
+
+
+static void putarglist(FILE *f,struct macarg *ma)
+{
+  struct macarg *a;
+  uint32_t n;
+
+  for (n=0,a=ma; a!=NULL; a=a->argnext)
+    n++;
+  put32(f,n);
+  for (a=ma; a!=NULL; a=a->argnext)
+    putarg(f,a);
+}
+
+
+static void write_file(struct source_file *srcfile,void *f)
+{
+  fw8(f,PCH_FILE);
+  putstr(f,srcfile->path,strlen(srcfile->path));
+  put32(f,srcfile->size);
+  put32(f,source_hash(srcfile->text,srcfile->size));
+}
+
+
+static void write_symbol(FILE *f,symbol *sym)
+{
+  uint64_t v;
+  taddr val;
+
+  if (sym->flags & VASMINTERN)
+    return;
+  if (sym->type == IMPORT)
+    val = 0;
+  else if (sym->type!=EXPRESSION || !eval_expr(sym->expr,&val,NULL,0)) {
+    /* labels and expressions, which are not constant */
+    general_error(93,sym->name);
+    return;
+  }
+  v = (uint64_t)(int64_t)val;
+  fw8(f,PCH_SYMBOL);
+  putstr(f,sym->name,strlen(sym->name));
+  put32(f,sym->type);
+  put32(f,sym->flags & ~(USED|REFERENCED|INEVAL));
+  put32(f,v>>32);
+  put32(f,v);
+}
+
+
+#ifdef HAVE_REGSYMS
+static void write_regsym(regsym *rsym,int no_case,void *f)
+{
+  fw8(f,PCH_REGSYM);
+  putstr(f,rsym->reg_name,strlen(rsym->reg_name));
+  put32(f,rsym->reg_type);
+  put32(f,rsym->reg_flags);
+  put32(f,rsym->reg_num);
+  put32(f,no_case);
+}
+#endif
+
+
+static void write_macro(macro *m,void *f)
+{
+  fw8(f,PCH_MACRO);
+  putstr(f,m->name,strlen(m->name));
+  putstr(f,m->defsrc->name,strlen(m->defsrc->name));
+  put32(f,m->defline);
+  put32(f,m->num_argnames);
+  put32(f,m->vararg);
+  putarglist(f,m->argnames);
+  putarglist(f,m->defaults);
+  putstr(f,m->text,m->size);
+}
+
+
+#ifdef SYNTAX_PCH_STATE
+static void putoptstr(FILE *f,const char *s)
+{
+  if (s != NULL) {
+    put32(f,1);
+    putstr(f,s,strlen(s));
+  }
+  else {
+    put32(f,0);
+    putstr(f,emptystr,0);
+  }
+}
+
+
+static void write_syntax_state(const char *name,const char *s1,
+                               const char *s2,uint32_t num,void *f)
+{
+  fw8(f,PCH_SYNTAX);
+  putstr(f,name,strlen(name));
+  putoptstr(f,s1);
+  putoptstr(f,s2);
+  put32(f,num);
+}
+#endif
+
+
+/* Write the symbols and macros of the assembled headers into an image.
+   The headers must not generate any code or data. */
+void write_pch(const char *name,section *sec,symbol *sym)
+{
+  FILE *f;
+
+  for (; sec!=NULL; sec=sec->next) {
+    if (get_sec_size(sec) != 0) {
+      general_error(94,sec->name);
+      return;
+    }
+  }
+
+  if ((f = fopen(name,"wb")) == NULL) {
+    general_error(13,name);
+    return;
+  }
+  fwdata(f,pch_id,4);
+  put32(f,PCH_VERSION);
+  put32(f,options_hash);
+  walk_source_files(write_file,f);
+
+  /* oldest symbols first, to keep their order after loading */
+  if (sym != NULL) {
+    while (sym->next != NULL)
+      sym = sym->next;
+    for (; sym!=NULL; sym=sym->prev)
+      write_symbol(f,sym);
+  }
+#ifdef HAVE_REGSYMS
+  walk_regsyms(write_regsym,f);
+#endif
+  walk_macros(write_macro,f);
+#ifdef SYNTAX_PCH_STATE
+  save_syntax_state(write_syntax_state,f);
+#endif
+  fw8(f,PCH_END);
+  fclose(f);
+}
+
+
+static int get8(struct pch_reader *r)
+{
+  if (r->p >= r->end) {
+    r->bad = 1;
+    return PCH_END;
+  }
+  return *r->p++;
+}
+
+
+static uint32_t get32(struct pch_reader *r)
+{
+  uint32_t v;
+
+  if (r->end - r->p < 4) {
+    r->bad = 1;
+    r->p = r->end;
+    return 0;
+  }
+  v = ((uint32_t)r->p[0] << 24) | ((uint32_t)r->p[1] << 16) |
+      ((uint32_t)r->p[2] << 8) | (uint32_t)r->p[3];
+  r->p += 4;
+  return v;
+}
+
+
+static char *getstr(struct pch_reader *r,size_t *len)
+{
+  size_t n = get32(r);
+  char *s;
+
+  if (r->bad || (size_t)(r->end - r->p) <= n || r->p[n] != 0) {
+    r->bad = 1;
+    r->p = r->end;
+    n = 0;
+    s = emptystr;
+  }
+  else {
+    s = (char *)r->p;
+    r->p += n + 1;
+  }
+  if (len)
+    *len = n;
+  return s;
+}
+
+
+static struct macarg *getarglist(struct pch_reader *r)
+{
+  struct macarg *list = NULL;
+  uint32_t n = get32(r);
+  size_t len;
+  char *s;
+
+  while (n-- && !r->bad) {
+    int required = get32(r) != 0;
+
+    s = getstr(r,&len);
+    addmacarg(&list,required?NULL:s,s+len);
+  }
+  return list;
+}
+
+
+#ifdef SYNTAX_PCH_STATE
+static char *getoptstr(struct pch_reader *r)
+{
+  int present = get32(r) != 0;
+  char *s = getstr(r,NULL);
+
+  return present ? s : NULL;
+}
+#endif
+
+
+/* source instance for error messages in macros from a header */
+static source *defsource(const char *name)
+{
+  static source *last;
+
+  if (last==NULL || strcmp(last->name,name))
+    last = new_source(name,NULL,NULL,0);
+  return last;
+}
+
+
+/* Read the records of an image. Without load only check whether they are
+   complete and whether the headers are unchanged. */
+static int read_records(struct pch_reader *r,const char *name,int load)
+{
+  uint32_t type,flags,num,hi,lo;
+  size_t len;
+  char *s,*t;
+  int rt;
+
+  while ((rt = get8(r)) != PCH_END) {
+    switch (rt) {
+      case PCH_FILE:
+        s = getstr(r,NULL);
+        len = get32(r);
+        num = get32(r);
+        if (r->bad)
+          break;
+        if (load)
+          skip_source(s);
+        else if (!check_source(s,len,num)) {
+          general_error(96,name,s);  /* header changed */
+          return 0;
+        }
+        break;
+
+      case PCH_SYMBOL:
+        s = getstr(r,NULL);
+        type = get32(r);
+        flags = get32(r);
+        hi = get32(r);
+        lo = get32(r);
+        if (type!=EXPRESSION && type!=IMPORT)
+          r->bad = 1;
+        if (load && find_symbol(s)==NULL) {
+          symbol *sym;
+
+          if (type == IMPORT)
+            sym = new_import(s);
+          else
+            sym = new_abs(s,number_expr((taddr)(((uint64_t)hi<<32)|lo)));
+          sym->flags |= flags;
+        }
+        break;
+
+#ifdef HAVE_REGSYMS
+      case PCH_REGSYM:
+        s = getstr(r,NULL);
+        type = get32(r);
+        flags = get32(r);
+        num = get32(r);
+        rt = get32(r);
+        if (load)
+          new_regsym(1,rt,s,type,flags,num);
+        break;
+#endif
+
+      case PCH_MACRO:
+        s = getstr(r,NULL);
+        t = getstr(r,NULL);
+        if (load && find_macro(s,strlen(s))==NULL) {
+          macro *m = mymalloc(sizeof(macro));
+
+          m->name = intern_name(s);
+          m->defsrc = defsource(t);
+          m->defline = get32(r);
+          m->srcdebug = 0;  /* there is no source text to debug */
+          m->num_argnames = (int)get32(r);
+          m->vararg = (int)get32(r);
+          m->argnames = getarglist(r);
+          m->defaults = getarglist(r);
+          m->text = getstr(r,&m->size);
+          m->recursions = 0;
+          define_macro(m);
+        }
+        else {
+          get32(r);
+          get32(r);
+          get32(r);
+          getarglist(r);
+          getarglist(r);
+          getstr(r,NULL);
+        }
+        break;
+
+#ifdef SYNTAX_PCH_STATE
+      case PCH_SYNTAX:
+        {
+          char *u;
+
+          s = getstr(r,NULL);
+          t = getoptstr(r);
+          u = getoptstr(r);
+          num = get32(r);
+          if (load && !r->bad)
+            load_syntax_state(s,t,u,num);
+        }
+        break;
+#endif
+
+      default:
+        r->bad = 1;
+        break;
+    }
+    if (r->bad)
+      break;
+  }
+  if (r->bad) {
+    general_error(95,name,"image is corrupt");
+    return 0;
+  }
+  return 1;
+}
+
+
+/* Load the symbols and macros from a precompiled header image, when the
+   header sources and the options did not change. Then the headers are
+   skipped when included. Otherwise they are assembled as usual. */
+void read_pch(const char *name)
+{
+  struct pch_reader r;
+  uint8_t *image;
+  size_t size;
+  FILE *f;
+
+  if ((f = fopen(name,"rb")) == NULL) {
+    general_error(95,name,"cannot open");
+    return;
+  }
+  size = filesize(f);
+  image = mymalloc(size + 1);
+  if (fread(image,1,size,f) != size) {
+    fclose(f);
+    myfree(image);
+    general_error(95,name,"read error");
+    return;
+  }
+  fclose(f);
+
+  r.p = image;
+  r.end = image + size;
+  r.bad = 0;
+  if (size<12 || memcmp(image,pch_id,4)) {
+    general_error(95,name,"not a precompiled header");
+  }
+  else {
+    r.p += 4;
+    if (get32(&r) != PCH_VERSION)
+      general_error(95,name,"wrong version");
+    else if (get32(&r) != options_hash)
+      general_error(95,name,"different options");
+    else if (read_records(&r,name,0)) {
+      r.p = image + 12;
+      read_records(&r,name,1);
+      return;  /* the image stays in memory, with all macro texts */
+    }
+  }
+  myfree(image);
+}
@@ -0,0 +1,11 @@
+/* pch.h - precompiled headers */
+/* (c) 2025 Bryan Woodruff, Cortexa LLC */
+
+#ifndef PCH_H
+#define PCH_H
+
+void pch_options(int,char **);
+void read_pch(const char *);
+void write_pch(const char *,section *,symbol *);
+
+#endif /* PCH_H */
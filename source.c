@@ -13,10 +13,14 @@
 
 char *compile_dir;
 int ignore_multinc,relpath,nocompdir,depend,depend_all;
+size_t src_bytes;  /* total size of all source files read */
+unsigned long src_count;  /* sources created, including macros */
 
 static struct include_path *first_incpath;
 static struct source_file *first_source;
 static struct deplist *first_depend,*last_depend;
+static struct deplist *first_skipped;  /* covered by a precompiled header */
+static char found_path[MAXPATHLEN];    /* where search_file() found a file */
 
 
 void source_debug_init(int type,void *data)
@@ -96,6 +100,7 @@ static FILE *open_path(char *compdir,char *path,char *name,char *mode)
     if (f = fopen(pathbuf,mode)) {
       if (depend_all || !abs_path(pathbuf))
         add_depend(pathbuf);
+      strcpy(found_path,pathbuf);
       return f;
     }
   }
@@ -103,7 +108,7 @@ static FILE *open_path(char *compdir,char *path,char *name,char *mode)
 }
 
 
-static FILE *locate_file(char *filename,char *mode,
+static FILE *search_file(char *filename,char *mode,
                          struct include_path **ipath_used,int *cdbased)
 {
   struct include_path *ipath;
@@ -114,11 +119,12 @@ static FILE *locate_file(char *filename,char *mode,
 
   if (!relpath && abs_path(filename)) {
     /* file name is absolute, then don't use any include paths */
-    if (f = fopen(filename,mode)) {
+    if (strlen(filename)<MAXPATHLEN && (f = fopen(filename,mode))) {
       if (depend_all)
         add_depend(filename);
       if (ipath_used)
         *ipath_used = NULL;  /* no path used, file name was absolute */
+      strcpy(found_path,filename);
       return f;
     }
   }
@@ -138,15 +144,82 @@ static FILE *locate_file(char *filename,char *mode,
       }
     }
   }
-  general_error(12,filename);
   return NULL;
 }
 
 
-static struct source_file *read_source_file(FILE *f)
+static FILE *locate_file(char *filename,char *mode,
+                         struct include_path **ipath_used,int *cdbased)
+{
+  FILE *f;
+
+  if ((f = search_file(filename,mode,ipath_used,cdbased)) == NULL)
+    general_error(12,filename);
+  return f;
+}
+
+
+/* Returns an allocated copy of a path without "." components, and with
+   "dir/.." removed, so different names of the same file compare equal. */
+static char *normalize_path(const char *path)
+{
+  char *new = mymalloc(strlen(path)+1);
+  char *d = new;
+  char *top;  /* components before it cannot be removed */
+  const char *s = path;
+  size_t n;
+
+  if (*s=='/' || *s=='\\')
+    *d++ = *s++;
+  top = d;
+  while (*s) {
+    for (n=0; s[n]!='\0' && s[n]!='/' && s[n]!='\\'; n++);
+    if (n==0 || (n==1 && s[0]=='.')) {
+      /* skip empty and "." components */
+    }
+    else if (n==2 && s[0]=='.' && s[1]=='.' && d>top) {
+      /* remove the previous component */
+      for (d--; d>top && d[-1]!='/' && d[-1]!='\\'; d--);
+    }
+    else {
+      memcpy(d,s,n);
+      d += n;
+      if (s[n] != '\0')
+        *d++ = s[n];
+      if (n==2 && s[0]=='.' && s[1]=='.')
+        top = d;  /* leading "..", keep it */
+    }
+    s += n;
+    if (*s != '\0')
+      s++;
+  }
+  *d = '\0';
+  return new;
+}
+
+
+static struct source_file *new_source_file(char *text,size_t size)
 {
   static int srcfileidx;
   struct source_file *srcfile;
+
+  srcfile = mymalloc(sizeof(struct source_file));
+  srcfile->next = NULL;
+  srcfile->name = NULL;
+  srcfile->path = NULL;
+  srcfile->incpath = NULL;
+  srcfile->compdir_based = 0;
+  srcfile->text = text;
+  srcfile->size = size;
+  srcfile->index = ++srcfileidx;
+  src_bytes += size;
+  return srcfile;
+}
+
+
+/* read a source text, which is terminated by a newline and a nul-byte */
+static char *read_source_text(FILE *f,size_t *psize)
+{
   char *text;
   size_t size;
 
@@ -160,37 +233,32 @@ static struct source_file *read_source_file(FILE *f)
       break;
     }
   }
-  if (feof(f)) {
-    if (size > 0) {
-      text = myrealloc(text,size+2);
-      *(text+size) = '\n';
-      *(text+size+1) = '\0';
-      size++;
-    }
-    else {
-      myfree(text);
-      text = "\n";
-      size = 1;
-    }
-    srcfile = mymalloc(sizeof(struct source_file));
-    srcfile->next = NULL;
-    srcfile->name = NULL;
-    srcfile->incpath = NULL;
-    srcfile->compdir_based = 0;
-    srcfile->text = text;
-    srcfile->size = size;
-    srcfile->index = ++srcfileidx;
-  }
-  else {
-    general_error(29,filename);
-    srcfile = NULL;
+  if (!feof(f)) {
+    myfree(text);
+    return NULL;
   }
-  return srcfile;
+  text = myrealloc(text,size+2);
+  *(text+size) = '\n';
+  *(text+size+1) = '\0';
+  *psize = size + 1;
+  return text;
+}
+
+
+static struct source_file *read_source_file(FILE *f)
+{
+  char *text;
+  size_t size;
+
+  if (text = read_source_text(f,&size))
+    return new_source_file(text,size);
+  general_error(29,filename);
+  return NULL;
 }
 
 
 /* create a new source text instance, which has cur_src as parent */
-source *new_source(char *srcname,struct source_file *srcfile,
+source *new_source(const char *srcname,struct source_file *srcfile,
                    char *text,size_t size)
 {
   static unsigned long id = 0;
@@ -208,10 +276,11 @@ source *new_source(char *srcname,struct source_file *srcfile,
     }
   }
 
+  src_count++;
   s->parent = cur_src;
   s->parent_line = cur_src ? cur_src->line : 0;
   s->srcfile = srcfile; /* NULL for macros and repetitions */
-  s->name = mystrdup(srcname);
+  s->name = intern_name(srcname);
   s->text = text;
   s->size = size;
   s->defsrc = NULL;
@@ -255,7 +324,7 @@ source *stdin_source(void)
   struct source_file *srcfile;
 
   if (srcfile = read_source_file(stdin)) {
-    srcfile->name = "stdin";
+    srcfile->name = srcfile->path = "stdin";
     srcfile->next = first_source;
     first_source = srcfile;
     cur_src = new_source(srcfile->name,srcfile,srcfile->text,srcfile->size);
@@ -265,10 +334,25 @@ source *stdin_source(void)
 }
 
 
+/* make a main source from a text in memory, which ends with a newline */
+source *memory_source(char *name,char *text,size_t size)
+{
+  struct source_file *srcfile;
+
+  srcfile = new_source_file(text,size);
+  srcfile->name = srcfile->path = name;
+  srcfile->next = first_source;
+  first_source = srcfile;
+  cur_src = new_source(srcfile->name,srcfile,srcfile->text,srcfile->size);
+  return cur_src;
+}
+
+
 source *include_source(char *inc_name)
 {
   struct source_file **nptr = &first_source;
   struct source_file *srcfile;
+  struct deplist *skip;
   char *filename;
 
   filename = convert_path(inc_name);
@@ -290,8 +374,21 @@ source *include_source(char *inc_name)
     FILE *f;
 
     if (f = locate_file(filename,"r",&ipath,&cdbased)) {
+      char *path = normalize_path(found_path);
+
+      /* ignore files, whose definitions were loaded from a precompiled
+         header, by the path where the file was found */
+      for (skip=first_skipped; skip; skip=skip->next) {
+        if (!filenamecmp(skip->filename,path)) {
+          fclose(f);
+          myfree(path);
+          myfree(filename);
+          return NULL;
+        }
+      }
       if (srcfile = read_source_file(f)) {
         srcfile->name = filename;
+        srcfile->path = path;
         srcfile->incpath = ipath;
         srcfile->compdir_based = cdbased;
         *nptr = srcfile;
@@ -311,6 +408,67 @@ source *include_source(char *inc_name)
 }
 
 
+/* hash code of a source text, used to validate precompiled headers */
+uint32_t source_hash(const char *text,size_t size)
+{
+  uint32_t h = 2166136261UL;  /* FNV-1a */
+
+  while (size--) {
+    /* new_source() replaces an EOF character in place */
+    h ^= *text!=0x1a ? (uint8_t)*text : '\n';
+    h *= 16777619UL;
+    text++;
+  }
+  return h;
+}
+
+
+/* check whether a source file, by the path where it was found, exists with
+   the given size and hash code */
+int check_source(char *path,size_t size,uint32_t hash)
+{
+  char *filename = convert_path(path);
+  int ok = 0;
+  FILE *f;
+
+  if (f = fopen(filename,"r")) {
+    char *text;
+    size_t n;
+
+    if (text = read_source_text(f,&n)) {
+      ok = n==size && source_hash(text,n)==hash;
+      myfree(text);
+    }
+    fclose(f);
+  }
+  myfree(filename);
+  return ok;
+}
+
+
+/* include_source() will ignore the file found at this path from now on */
+void skip_source(char *path)
+{
+  struct deplist *d = mymalloc(sizeof(struct deplist));
+  char *filename = convert_path(path);
+
+  d->filename = normalize_path(filename);
+  myfree(filename);
+  d->next = first_skipped;
+  first_skipped = d;
+}
+
+
+/* call fn for every source file read so far */
+void walk_source_files(void (*fn)(struct source_file *,void *),void *arg)
+{
+  struct source_file *srcfile;
+
+  for (srcfile=first_source; srcfile; srcfile=srcfile->next)
+    fn(srcfile,arg);
+}
+
+
 void include_binary_file(char *inname,size_t nbskip,size_t nbkeep)
 /* Locate a binary file and convert into a data atom. */
 {
@@ -17,6 +17,7 @@ struct source_file {
   int compdir_based;  /* path and file name based on compile directory */
   int index;
   char *name;
+  char *path;  /* normalized path, where the file was found */
   char *text;
   size_t size;
 };
@@ -26,7 +27,7 @@ struct source {
   struct source *parent;
   int parent_line;
   struct source_file *srcfile;
-  char *name;
+  const char *name;
   char *text;
   size_t size;
   struct source *defsrc;
@@ -68,12 +69,19 @@ struct deplist {
 
 extern char *compile_dir;
 extern int ignore_multinc,relpath,nocompdir,depend,depend_all;
+extern size_t src_bytes;
+extern unsigned long src_count;
 
 void write_depends(FILE *);
-source *new_source(char *,struct source_file *,char *,size_t);
+source *new_source(const char *,struct source_file *,char *,size_t);
 void end_source(source *);
 source *stdin_source(void);
+source *memory_source(char *,char *,size_t);
 source *include_source(char *);
+uint32_t source_hash(const char *,size_t);
+int check_source(char *,size_t,uint32_t);
+void skip_source(char *);
+void walk_source_files(void (*)(struct source_file *,void *),void *);
 void include_binary_file(char *,size_t,size_t);
 void source_debug_init(int,void *);
 struct include_path *new_include_path(char *);
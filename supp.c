@@ -5,6 +5,13 @@
 #include "vasm.h"
 #include "supp.h"
 
+unsigned long hot_stats[HS_NUM];
+const char *hot_stat_names[HS_NUM] = {
+  "eval_expr nodes","find_base calls","mnemonic trials",
+  "symbol rollbacks","allocations","allocated bytes",
+  "replayed iterations"
+};
+
 
 void initlist(struct list *l)
 /* initializes a list structure */
@@ -57,6 +64,8 @@ void *mymalloc(size_t sz)
   /* workaround for Electric Fence on 64-bit RISC */
   if (sz)
     sz = (sz + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1);
+  hot_stats[HS_ALLOC_CALLS]++;
+  hot_stats[HS_ALLOC_BYTES] += sz;
 
   if (debug) {
     if (sz == 0) {
@@ -20,6 +20,14 @@ void addtail(struct list *,struct node *);
 struct node *remnode(struct node *);
 struct node *remhead(struct list *);
 
+/* hot-path counters, reported by -stats */
+enum {
+  HS_EVAL_NODES,HS_FIND_BASE,HS_MNEMO_TRIALS,HS_SYM_ROLLBACKS,
+  HS_ALLOC_CALLS,HS_ALLOC_BYTES,HS_REPT_REPLAYS,HS_NUM
+};
+extern unsigned long hot_stats[HS_NUM];
+extern const char *hot_stat_names[HS_NUM];
+
 void *mymalloc(size_t);
 void *mycalloc(size_t);
 void *myrealloc(const void *,size_t);
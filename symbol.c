@@ -7,13 +7,46 @@
 symbol *first_symbol;
 
 static symbol *saved_symbol;
+static int symbols_saved;
 static const char *last_global_label=emptystr;
 
+/* symbol definitions and changes, see symbol_updates() */
+static unsigned long symupdates;
+static struct intsym {
+  symbol *sym;
+  expr *exp;    /* last seen expression */
+  int num;      /* it was a number with this value: */
+  taddr val;
+} *intsyms;
+static size_t nintsyms,maxintsyms;
+
 #ifndef SYMHTABSIZE
 #define SYMHTABSIZE 0x10000
 #endif
 static hashtable *symhash;
 
+/* Local symbols, named " global local", are not kept in symhash, but in
+   a table owned by the scope of their global label, keyed by the local
+   part of the name. Scope records are created once per global name. */
+struct symscope {
+  const char *name;
+  size_t len;
+  hashtable *locals;
+};
+#ifndef SCOPEHTABSIZE
+#define SCOPEHTABSIZE 0x4000
+#endif
+#define LOCHTABSIZE 0x10
+static hashtable *scopehash;
+static struct symscope *last_global_scope;
+static size_t last_global_len;  /* (size_t)-1 when not yet known */
+
+/* scopes of the names in make_local_label()'s buffers */
+static struct {
+  const char *str;
+  struct symscope *scope;
+} local_buf_scope[EXPBUFNO+1];
+
 #ifdef HAVE_REGSYMS
 static hashtable *regsymhash;
 #endif
@@ -101,14 +134,123 @@ const char *get_bind_name(symbol *p)
 }
 
 
+static struct symscope *find_scope(const char *name,size_t len)
+/* find the scope record of a global name, create it when missing */
+{
+  struct symscope *sc;
+  hashdata data;
+
+  if (nocase ? find_namelen_nc(scopehash,name,len,&data) :
+               find_namelen(scopehash,name,len,&data))
+    return data.ptr;
+  sc = mymalloc(sizeof(struct symscope));
+  sc->name = intern_namelen(name,len);
+  sc->len = len;
+  sc->locals = NULL;
+  data.ptr = sc;
+  add_hashentry(scopehash,sc->name,data,nocase);
+  return sc;
+}
+
+
+static struct symscope *glob_scope(const char *glob,size_t glen)
+/* scope for a global name, NULL when it would be split differently */
+{
+  return memchr(glob,' ',glen) ? NULL : find_scope(glob,glen);
+}
+
+
+static const char *local_part(const char *name,struct symscope **scope)
+/* return the local part of a local symbol name and set its scope,
+   return NULL when the name is not local */
+{
+  const char *p;
+  int i;
+
+  if (*name != ' ')
+    return NULL;
+  for (i=0; i<=EXPBUFNO; i++) {
+    if (name==local_buf_scope[i].str && local_buf_scope[i].scope!=NULL) {
+      /* name was just made by make_local_label(), scope is known */
+      *scope = local_buf_scope[i].scope;
+      return name + (*scope)->len + 2;
+    }
+  }
+  if ((p = strchr(name+1,' ')) == NULL)
+    return NULL;
+  *scope = find_scope(name+1,p-(name+1));
+  return p + 1;
+}
+
+
+static void add_symhash(const char *name,hashdata data)
+/* name must be interned */
+{
+  struct symscope *sc;
+  const char *loc;
+
+  if (loc = local_part(name,&sc)) {
+    if (sc->locals == NULL) {
+      sc->locals = new_hashtable(LOCHTABSIZE);
+      sc->locals->name = "local symbols";
+    }
+    else if (sc->locals->num >= 2*sc->locals->size)
+      resize_hashtable(sc->locals,4*sc->locals->size);
+    add_hashentry(sc->locals,loc,data,nocase);
+  }
+  else if (nocase)
+    add_hashentry(symhash,name,data,1);
+  else
+    add_hashentry_hc(symhash,name,interned_hash(name),data);
+}
+
+
+static void rem_symhash(const char *name)
+/* name must be interned */
+{
+  struct symscope *sc;
+  const char *loc;
+
+  if (loc = local_part(name,&sc)) {
+    if (sc->locals == NULL)
+      ierror(0);
+    rem_hashentry(sc->locals,loc,nocase);
+  }
+  else if (nocase)
+    rem_hashentry(symhash,name,1);
+  else
+    rem_hashentry_hc(symhash,name,interned_hash(name),0);
+}
+
+
+static void free_symbol(symbol *symp)
+{
+  size_t i;
+
+  if (symp->flags & VASMINTERN) {
+    for (i=0; i<nintsyms; i++) {
+      if (intsyms[i].sym == symp) {
+        intsyms[i] = intsyms[--nintsyms];
+        break;
+      }
+    }
+  }
+  rem_symhash(symp->name);
+  myfree(symp);
+}
+
+
 void add_symbol(symbol *p)
 {
   hashdata data;
 
-  p->next = first_symbol;
+  symupdates++;
+  p->prev = NULL;
+  if (p->next = first_symbol)
+    first_symbol->prev = p;
   first_symbol = p;
   data.ptr = p;
-  add_hashentry(symhash,p->name,data,nocase);
+  add_symhash(p->name,data);
 }
 
 
@@ -116,36 +258,42 @@ void rem_symbol(symbol *symp)
 /* Symbol name must be unique!
    Symbol list will be modified! Be careful while iterating over it! */
 {
-  /* remove from list */
-  if (first_symbol != symp) {
-    symbol *symlist;
-    for (symlist=first_symbol; symlist; symlist=symlist->next) {
-      if (symlist->next == symp) {
-        symlist->next = symp->next;
-        break;
-      }
-    }
-  }
+  /* unlink from list */
+  if (symp->prev)
+    symp->prev->next = symp->next;
   else
     first_symbol = symp->next;
+  if (symp->next)
+    symp->next->prev = symp->prev;
+  if (symbols_saved && symp==saved_symbol)
+    saved_symbol = symp->next;  /* keep the mark valid */
 
-  /* remove from hash table and deallocate */
-  rem_hashentry(symhash,symp->name,nocase);
-  myfree((void *)symp->name);
-  myfree(symp);
+  /* remove from hash table and deallocate, the name stays interned */
+  free_symbol(symp);
 }
 
 
 symbol *find_symbol(const char *name)
 {
+  struct symscope *sc;
+  const char *loc;
+  hashtable *ht;
   hashdata data;
 
+  if (loc = local_part(name,&sc)) {
+    if ((ht = sc->locals) == NULL)
+      return 0;
+    name = loc;
+  }
+  else
+    ht = symhash;
+
   if (nocase) {
-    if (!find_name_nc(symhash,name,&data))
+    if (!find_name_nc(ht,name,&data))
       return 0;
   }
   else {
-    if (!find_name(symhash,name,&data))
+    if (!find_name(ht,name,&data))
       return 0;
   }
   return data.ptr;
@@ -157,46 +305,51 @@ void refer_symbol(symbol *sym,const char *refname)
 {
   hashdata data;
   data.ptr = sym;
-  add_hashentry(symhash,refname,data,nocase);
+  add_symhash(intern_name(refname),data);
 }
 
 
 void save_symbols(void)
-/* remember current list of symbols to be restored later */
+/* set a mark at the current head of the symbol list to be restored later */
 {
   saved_symbol = first_symbol;
+  symbols_saved = 1;
 }
 
 
 void restore_symbols(void)
-/* restore to a previously saved symbol list */
+/* truncate the symbol list to a previously saved mark, keeping only
+   the protected symbols defined since then */
 {
   symbol *firstprot=NULL, *lastprot=NULL;
   symbol *symp;
 
-  if (saved_symbol) {
+  if (symbols_saved) {
+    hot_stats[HS_SYM_ROLLBACKS]++;
     while (first_symbol != saved_symbol) {
       symp = first_symbol;
       first_symbol = symp->next;
       if (symp->flags & PROTECTED) {
         /* keep this symbol */
-        symp->next = firstprot;
+        if (symp->next = firstprot)
+          firstprot->prev = symp;
         firstprot = symp;
         if (!lastprot)
           lastprot = symp;
       }
-      else {
-        rem_hashentry(symhash,symp->name,nocase);
-        myfree((void *)symp->name);
-        myfree(symp);
-      }
+      else
+        free_symbol(symp);
     }
+    if (first_symbol)
+      first_symbol->prev = lastprot;
     if (firstprot) {
       /* add protected symbols to the list again */
       lastprot->next = first_symbol;
+      firstprot->prev = NULL;
       first_symbol = firstprot;
     }
     saved_symbol = NULL;
+    symbols_saved = 0;
   }
 }
 
@@ -221,6 +374,8 @@ const char *set_last_global_label(const char *name)
   const char *prevlgl = last_global_label;
 
   last_global_label = name;
+  last_global_scope = NULL;
+  last_global_len = (size_t)-1;
   return prevlgl;
 }
 
@@ -247,13 +402,26 @@ strbuf *make_local_label(int n,
    return a pointer to one of two static string buffers */
 {
   static strbuf buf[EXPBUFNO+1];
+  static struct symscope *last_scope;
+  struct symscope *sc;
   char *p;
 
   if (glen == 0) {
-    /* use the last defined global label */
+    /* use the last defined global label, its scope is only looked up once */
+    if (last_global_len == (size_t)-1) {
+      last_global_len = strlen(last_global_label);
+      last_global_scope = glob_scope(last_global_label,last_global_len);
+    }
     glob = last_global_label;
-    glen = strlen(last_global_label);
+    glen = last_global_len;
+    sc = last_global_scope;
   }
+  else if (last_scope!=NULL && last_scope->len==glen &&
+           !memcmp(last_scope->name,glob,glen))
+    sc = last_scope;
+  else
+    sc = last_scope = glob_scope(glob,glen);
+
   p = strbuf_alloc(&buf[n],llen+glen+3);
   *p++ = ' ';
   if (glen) {
@@ -264,6 +432,8 @@ strbuf *make_local_label(int n,
   memcpy(p,loc,llen);
   *(p + llen) = '\0';
   buf[n].len = llen+glen+2;  /* new string length in buffer */
+  local_buf_scope[n].str = buf[n].str;
+  local_buf_scope[n].scope = sc;
   return &buf[n];
 }
 
@@ -278,11 +448,12 @@ symbol *new_abs(const char *name,expr *tree)
       general_error(67,name); /* repeatedly defined symbol (error) */
     if (new->type!=IMPORT && new->type!=EXPRESSION)
       general_error(5,name);  /* symbol redefined (warning) */
+    symupdates++;
     add=0;
   }
   else {
     new = mymalloc(sizeof(*new));
-    new->name = mystrdup(name);
+    new->name = intern_name(name);
     add = 1;
   }
 
@@ -321,7 +492,7 @@ symbol *new_import(const char *name)
   new = mymalloc(sizeof(*new));
   new->type = IMPORT;
   new->flags = 0;
-  new->name = mystrdup(name);
+  new->name = intern_name(name);
   new->sec = 0;
   new->pc = 0;
   new->size = 0;
@@ -382,11 +553,12 @@ symbol *new_labsym(section *sec,const char *name)
       *new = *old;
       general_error(74,name);  /* label redefined (error) */
     }
+    symupdates++;
     add = 0;
   }
   else {
     new = mymalloc(sizeof(*new));
-    new->name = mystrdup(name);
+    new->name = intern_name(name);
     add = 1;
   }
 
@@ -402,7 +574,7 @@ symbol *new_labsym(section *sec,const char *name)
   }
 
   if (!is_local_symbol_name(name))
-    last_global_label = new->name;
+    set_last_global_label(new->name);
 
   if (sec->flags & ABSOLUTE)
     new->flags |= ABSLABEL;
@@ -434,6 +606,14 @@ symbol *internal_abs(const char *name)
   else {
     new = new_abs(name,number_expr(0));
     new->flags |= VASMINTERN;
+    if (nintsyms >= maxintsyms) {
+      maxintsyms = maxintsyms ? maxintsyms*2 : 16;
+      intsyms = myrealloc(intsyms,maxintsyms*sizeof(struct intsym));
+    }
+    intsyms[nintsyms].sym = new;
+    intsyms[nintsyms].exp = new->expr;
+    intsyms[nintsyms].num = 1;
+    intsyms[nintsyms++].val = 0;
   }
   return new;
 }
@@ -454,6 +634,33 @@ expr *set_internal_abs(const char *name,taddr newval)
 }
 
 
+unsigned long symbol_updates(void)
+/* Returns a counter of symbol definitions and redefinitions. Internal
+   symbols are often assigned directly, so their expressions are compared
+   with those seen on the previous call, which only counts when the value
+   changed. Equal results mean that nothing was defined in between. */
+{
+  struct intsym *is;
+  size_t i;
+
+  for (i=0,is=intsyms; i<nintsyms; i++,is++) {
+    if (is->exp != is->sym->expr) {
+      if ((is->exp = is->sym->expr)!=NULL && is->exp->type==NUM) {
+        if (!is->num || is->exp->c.val!=is->val)
+          symupdates++;
+        is->num = 1;
+        is->val = is->exp->c.val;
+      }
+      else {
+        symupdates++;
+        is->num = 0;
+      }
+    }
+  }
+  return symupdates;
+}
+
+
 #ifdef HAVE_REGSYMS
 void add_regsym(regsym *rsym,int no_case)
 {
@@ -516,6 +723,19 @@ regsym *new_regsym(int redef,int no_case,const char *name,int type,
 }
 
 
+/* call fn for every register symbol, with its case-sensitivity */
+void walk_regsyms(void (*fn)(regsym *,int,void *),void *arg)
+{
+  hashentry *e;
+  size_t i;
+
+  for (i=0; i<regsymhash->size; i++) {
+    for (e=regsymhash->entries[i]; e!=NULL; e=e->next)
+      fn(e->data.ptr,e->hash!=hashcode(e->name),arg);
+  }
+}
+
+
 /* remove an already defined register symbol from the hash table */
 int undef_regsym(const char *name,int no_case,int type)
 {
@@ -543,8 +763,13 @@ int undef_regsym(const char *name,int no_case,int type)
 int init_symbol(void)
 {
   symhash = new_hashtable(SYMHTABSIZE);
+  symhash->name = "symbols";
+  scopehash = new_hashtable(SCOPEHTABSIZE);
+  scopehash->name = "symbol scopes";
+  last_global_len = (size_t)-1;
 #ifdef HAVE_REGSYMS
   regsymhash = new_hashtable(REGSYMHTSIZE);
+  regsymhash->name = "register symbols";
 #endif
   return 1;
 }
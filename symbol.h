@@ -41,6 +41,7 @@
 
 struct symbol {
   struct symbol *next;
+  struct symbol *prev;  /* valid until output modules reorder the list */
   int type;
   uint32_t flags;
   const char *name;
@@ -91,6 +92,7 @@ symbol *new_labsym(section *,const char *);
 symbol *new_tmplabel(section *);
 symbol *internal_abs(const char *);
 expr *set_internal_abs(const char *,taddr);
+unsigned long symbol_updates(void);
 
 #ifdef HAVE_REGSYMS
 void add_regsym(regsym *,int);
@@ -98,6 +100,7 @@ regsym *find_regsym(const char *,int);
 regsym *find_regsym_nc(const char *,int);
 regsym *new_regsym(int,int,const char *,int,unsigned int,unsigned int);
 int undef_regsym(const char *,int,int);
+void walk_regsyms(void (*)(regsym *,int,void *),void *);
 #endif /* HAVE_REGSYMS */
 
 void write_symbols_edtasm(const char *);
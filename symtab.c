@@ -4,8 +4,11 @@
 
 #include "vasm.h"
 
+hashtable *first_hashtable;  /* all hash tables, for -stats */
+
 hashtable *new_hashtable(size_t size)
 {
+  static hashtable *last_hashtable;
   hashtable *new = mymalloc(sizeof(*new));
 
 #ifdef LOWMEM
@@ -16,6 +19,15 @@ hashtable *new_hashtable(size_t size)
   new->size = size;
   new->collisions = 0;
   new->entries = mycalloc(size*sizeof(*new->entries));
+  new->next = NULL;
+  new->name = NULL;
+  new->num = 0;
+  new->lookups = new->probes = 0;
+  if (last_hashtable)
+    last_hashtable->next = new;
+  else
+    first_hashtable = new;
+  last_hashtable = new;
   return new;
 }
 
@@ -60,14 +72,20 @@ size_t hashcodelen_nc(const char *name,int len)
 /* add to hashtable; name must be unique */
 void add_hashentry(hashtable *ht,const char *name,hashdata data,int no_case)
 {
-  size_t i=no_case?(hashcode_nc(name)%ht->size):(hashcode(name)%ht->size);
+  add_hashentry_hc(ht,name,no_case?hashcode_nc(name):hashcode(name),data);
+}
+
+/* same as above, with a precomputed hash code */
+void add_hashentry_hc(hashtable *ht,const char *name,size_t hc,hashdata data)
+{
+  size_t i=hc%ht->size;
   hashentry *new=mymalloc(sizeof(*new));
   new->name=name;
+  new->hash=hc;
   new->data=data;
-  if(debug){
-    if(ht->entries[i])
-      ht->collisions++;
-  }
+  if(ht->entries[i])
+    ht->collisions++;
+  ht->num++;
   new->next=ht->entries[i];
   ht->entries[i]=new;
 }
@@ -75,16 +93,23 @@ void add_hashentry(hashtable *ht,const char *name,hashdata data,int no_case)
 /* remove from hashtable; name must be unique */
 void rem_hashentry(hashtable *ht,const char *name,int no_case)
 {
-  size_t i=no_case?(hashcode_nc(name)%ht->size):(hashcode(name)%ht->size);
+  rem_hashentry_hc(ht,name,no_case?hashcode_nc(name):hashcode(name),no_case);
+}
+
+/* same as above, with a precomputed hash code */
+void rem_hashentry_hc(hashtable *ht,const char *name,size_t hc,int no_case)
+{
   hashentry *p,*last;
 
-  for(p=ht->entries[i],last=NULL;p;p=p->next){
-    if(!strcmp(name,p->name)||(no_case&&!stricmp(name,p->name))){
+  for(p=ht->entries[hc%ht->size],last=NULL;p;p=p->next){
+    if(p->hash==hc&&(p->name==name||!strcmp(name,p->name)||
+                     (no_case&&!stricmp(name,p->name)))){
       if(last==NULL)
-        ht->entries[i]=p->next;
+        ht->entries[hc%ht->size]=p->next;
       else
         last->next=p->next;
       myfree(p);
+      ht->num--;
       return;
     }
     last=p;
@@ -95,14 +120,20 @@ void rem_hashentry(hashtable *ht,const char *name,int no_case)
 /* finds unique entry in hashtable */
 int find_name(hashtable *ht,const char *name,hashdata *result)
 {
-  size_t i=hashcode(name)%ht->size;
+  return find_name_hc(ht,name,hashcode(name),result);
+}
+
+/* same as above, with a precomputed hash code */
+int find_name_hc(hashtable *ht,const char *name,size_t hc,hashdata *result)
+{
   hashentry *p;
-  for(p=ht->entries[i];p;p=p->next){
-    if(!strcmp(name,p->name)){
+  ht->lookups++;
+  for(p=ht->entries[hc%ht->size];p;p=p->next){
+    ht->probes++;
+    if(p->hash==hc&&(p->name==name||!strcmp(name,p->name))){
       *result=p->data;
       return 1;
-    }else
-      ht->collisions++;
+    }
   }
   return 0;
 }
@@ -110,14 +141,15 @@ int find_name(hashtable *ht,const char *name,hashdata *result)
 /* same as above, but uses len instead of zero-terminated string */
 int find_namelen(hashtable *ht,const char *name,int len,hashdata *result)
 {
-  size_t i=hashcodelen(name,len)%ht->size;
+  size_t h=hashcodelen(name,len);
   hashentry *p;
-  for(p=ht->entries[i];p;p=p->next){
-    if(!strncmp(name,p->name,len)&&p->name[len]==0){
+  ht->lookups++;
+  for(p=ht->entries[h%ht->size];p;p=p->next){
+    ht->probes++;
+    if(p->hash==h&&!strncmp(name,p->name,len)&&p->name[len]==0){
       *result=p->data;
       return 1;
-    }else
-      ht->collisions++;
+    }
   }
   return 0;
 }
@@ -125,14 +157,15 @@ int find_namelen(hashtable *ht,const char *name,int len,hashdata *result)
 /* finds unique entry in hashtable - case insensitive */
 int find_name_nc(hashtable *ht,const char *name,hashdata *result)
 {
-  size_t i=hashcode_nc(name)%ht->size;
+  size_t h=hashcode_nc(name);
   hashentry *p;
-  for(p=ht->entries[i];p;p=p->next){
-    if(!stricmp(name,p->name)){
+  ht->lookups++;
+  for(p=ht->entries[h%ht->size];p;p=p->next){
+    ht->probes++;
+    if(p->hash==h&&!stricmp(name,p->name)){
       *result=p->data;
       return 1;
-    }else
-      ht->collisions++;
+    }
   }
   return 0;
 }
@@ -140,14 +173,125 @@ int find_name_nc(hashtable *ht,const char *name,hashdata *result)
 /* same as above, but uses len instead of zero-terminated string */
 int find_namelen_nc(hashtable *ht,const char *name,int len,hashdata *result)
 {
-  size_t i=hashcodelen_nc(name,len)%ht->size;
+  size_t h=hashcodelen_nc(name,len);
   hashentry *p;
-  for(p=ht->entries[i];p;p=p->next){
-    if(!strnicmp(name,p->name,len)&&p->name[len]==0){
+  ht->lookups++;
+  for(p=ht->entries[h%ht->size];p;p=p->next){
+    ht->probes++;
+    if(p->hash==h&&!strnicmp(name,p->name,len)&&p->name[len]==0){
       *result=p->data;
       return 1;
-    }else
-      ht->collisions++;
+    }
   }
   return 0;
 }
+
+/* change the number of buckets, entries are redistributed */
+void resize_hashtable(hashtable *ht,size_t size)
+{
+  hashentry **old=ht->entries,*p,*next;
+  size_t oldsize=ht->size,i,j;
+
+  ht->entries=mycalloc(size*sizeof(*ht->entries));
+  ht->size=size;
+  for(i=0;i<oldsize;i++){
+    for(p=old[i];p;p=next){
+      next=p->next;
+      j=p->hash%size;
+      p->next=ht->entries[j];
+      ht->entries[j]=p;
+    }
+  }
+  myfree(old);
+}
+
+
+/* Interned names are stored only once and are never freed, so equal
+   names share the same pointer. Each one is preceded by its hash code. */
+typedef struct iname {
+  struct iname *next;
+  size_t hash;
+  char str[1];
+} iname;
+
+#define INAMEOFFS offsetof(iname,str)
+#define INAMEALIGN (sizeof(size_t)>sizeof(void *)?sizeof(size_t):sizeof(void *))
+#ifndef INAMEHTABSIZE
+#define INAMEHTABSIZE 0x4000
+#endif
+#define INAMEBLKSIZE 0x10000
+
+static iname **inames;
+static size_t inames_size,inames_num;
+
+static iname *alloc_iname(size_t len)
+/* allocate from large blocks, to save the overhead of small allocations */
+{
+  static char *blk;
+  static size_t blkfree;
+  size_t sz=(INAMEOFFS+len+1+INAMEALIGN-1)&~(INAMEALIGN-1);
+  iname *in;
+
+  if(sz>INAMEBLKSIZE/4)
+    return mymalloc(sz);
+  if(sz>blkfree){
+    blk=mymalloc(INAMEBLKSIZE);
+    blkfree=INAMEBLKSIZE;
+  }
+  in=(iname *)blk;
+  blk+=sz;
+  blkfree-=sz;
+  return in;
+}
+
+/* return the interned copy of a name with the given length */
+const char *intern_namelen(const char *name,size_t len)
+{
+  size_t h=hashcodelen(name,len),i;
+  iname *in,*next;
+
+  if(inames==NULL){
+    inames_size=INAMEHTABSIZE;
+    inames=mycalloc(inames_size*sizeof(*inames));
+  }
+  for(in=inames[h%inames_size];in;in=in->next){
+    if(in->hash==h&&!strncmp(in->str,name,len)&&in->str[len]==0)
+      return in->str;
+  }
+  if(inames_num>=2*inames_size){
+    /* grow the table, the hash codes are already known */
+    iname **old=inames;
+    size_t oldsize=inames_size;
+
+    inames_size*=4;
+    inames=mycalloc(inames_size*sizeof(*inames));
+    for(i=0;i<oldsize;i++){
+      for(in=old[i];in;in=next){
+        next=in->next;
+        in->next=inames[in->hash%inames_size];
+        inames[in->hash%inames_size]=in;
+      }
+    }
+    myfree(old);
+  }
+  in=alloc_iname(len);
+  in->hash=h;
+  memcpy(in->str,name,len);
+  in->str[len]=0;
+  in->next=inames[h%inames_size];
+  inames[h%inames_size]=in;
+  inames_num++;
+  return in->str;
+}
+
+/* return the interned copy of a name */
+const char *intern_name(const char *name)
+{
+  return intern_namelen(name,strlen(name));
+}
+
+/* return the hash code of an interned name, same as hashcode() */
+size_t interned_hash(const char *name)
+{
+  return ((iname *)(name-INAMEOFFS))->hash;
+}
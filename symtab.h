@@ -10,6 +10,7 @@ typedef union hashdata {
 
 typedef struct hashentry {
   const char *name;
+  size_t hash;              /* full hash code of name */
   hashdata data;
   struct hashentry *next;
 } hashentry;
@@ -18,16 +19,31 @@ typedef struct hashtable {
   hashentry **entries;
   size_t size;
   int collisions;
+  /* statistics for -stats */
+  struct hashtable *next;
+  const char *name;
+  size_t num;               /* number of entries */
+  unsigned long lookups;
+  unsigned long probes;     /* entries compared during lookups */
 } hashtable;
 
+extern hashtable *first_hashtable;
+
 hashtable *new_hashtable(size_t);
 size_t hashcode(const char *);
 size_t hashcodelen(const char *,int);
 size_t hashcode_nc(const char *);
 size_t hashcodelen_nc(const char *,int);
 void add_hashentry(hashtable *,const char *,hashdata,int);
+void add_hashentry_hc(hashtable *,const char *,size_t,hashdata);
 void rem_hashentry(hashtable *,const char *,int);
+void rem_hashentry_hc(hashtable *,const char *,size_t,int);
 int find_name(hashtable *,const char *,hashdata *);
+int find_name_hc(hashtable *,const char *,size_t,hashdata *);
 int find_namelen(hashtable *,const char *,int,hashdata *);
 int find_name_nc(hashtable *,const char *,hashdata *);
 int find_namelen_nc(hashtable *,const char *,int,hashdata *);
+void resize_hashtable(hashtable *,size_t);
+const char *intern_name(const char *);
+const char *intern_namelen(const char *,size_t);
+size_t interned_hash(const char *);
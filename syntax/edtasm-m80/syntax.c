@@ -92,7 +92,6 @@ static unsigned long local_label_counter = 0;
 
 struct local_label {
   char *declared_name;    /* "LOOP" */
-  char *unique_name;      /* "??0001" */
   struct local_label *next;
 };
 
@@ -100,30 +99,31 @@ struct local_label {
 static struct local_label *current_local_labels = NULL;
 static char *current_macro_name = NULL;  /* Track macro being defined */
 
-/* Macro -> LOCAL label mapping */
-struct macro_local_map {
-  char *macro_name;               /* Name of macro */
-  struct local_label *local_list; /* List of LOCAL labels for this macro */
-  struct macro_local_map *next;   /* Linked list */
+/* LOCAL labels of a macro, with an open-addressed hash table of their
+   indexes, keyed by the declared name */
+struct macro_locals {
+  int num;
+  const char **names;             /* declared names, interned */
+  int *lens;
+  unsigned mask;                  /* hash table size - 1 */
+  int *slots;                     /* name index + 1, 0 for a free slot */
 };
 
-static struct macro_local_map *macro_local_head = NULL;
+#define MACLOCHTABSIZE 0x100
+static hashtable *macro_locals_hash;  /* macro name -> struct macro_locals */
 
-/* Per-invocation LOCAL label substitutions */
-struct local_subst {
-  char *declared_name;            /* Original LOCAL label name */
-  char *unique_name;              /* Generated unique name for this invocation */
-  struct local_subst *next;
-};
-
-/* Invocation ID -> LOCAL substitution mapping */
+/* Unique names of the LOCAL labels in one macro invocation */
 struct invocation_locals {
   unsigned long src_id;           /* source->id for this invocation */
-  struct local_subst *subst_list; /* Substitutions for this invocation */
-  struct invocation_locals *next;
+  struct macro_locals *locals;
+  const char **unique_names;      /* interned, same order as locals->names */
 };
 
-static struct invocation_locals *invocation_locals_head = NULL;
+/* invocations, open-addressed by src_id, and the last one looked up */
+static struct invocation_locals **invocation_table;
+static unsigned long invocation_mask,invocation_count;
+static struct invocation_locals *last_invocation;
+static unsigned long last_noloc_id = ~0UL;  /* invocation without LOCALs */
 
 static int parse_end = 0;
 static expr *carg1;
@@ -366,36 +366,17 @@ static atom *do_space(int size,expr *cnt,expr *fill)
 static void add_local_label(struct local_label **list, char *name)
 {
   struct local_label *local;
-  char unique[16];
 
-  /* Generate unique name: ??nnnn format */
-  sprintf(unique, "??%04lu", local_label_counter++);
+  /* every declaration consumes a number, like the invocations do */
+  local_label_counter++;
 
   /* Allocate and initialize local label entry */
   local = mymalloc(sizeof(struct local_label));
   local->declared_name = mystrdup(name);
-  local->unique_name = mystrdup(unique);
   local->next = *list;
   *list = local;
 }
 
-static char *find_local_label(struct local_label *list, char *name)
-{
-  struct local_label *local;
-
-  for (local = list; local != NULL; local = local->next) {
-    if (nocase) {
-      if (!stricmp(local->declared_name, name))
-        return local->unique_name;
-    }
-    else {
-      if (!strcmp(local->declared_name, name))
-        return local->unique_name;
-    }
-  }
-  return NULL;
-}
-
 static void free_local_labels(struct local_label **list)
 {
   struct local_label *local;
@@ -405,7 +386,6 @@ static void free_local_labels(struct local_label **list)
   while (local != NULL) {
     next = local->next;
     myfree(local->declared_name);
-    myfree(local->unique_name);
     myfree(local);
     local = next;
   }
@@ -413,55 +393,84 @@ static void free_local_labels(struct local_label **list)
 }
 
 
+static size_t local_hash(const char *name, int len)
+{
+  return nocase ? hashcodelen_nc(name, len) : hashcodelen(name, len);
+}
+
+
+/* Returns the index of a LOCAL label of a macro, or -1 */
+static int find_macro_local(struct macro_locals *ml, const char *name, int len)
+{
+  unsigned i;
+  int n;
+
+  for (i = local_hash(name, len) & ml->mask; (n = ml->slots[i]) != 0;
+       i = (i + 1) & ml->mask) {
+    n--;
+    if (ml->lens[n] == len &&
+        !(nocase ? strnicmp(ml->names[n], name, len) :
+                   strncmp(ml->names[n], name, len)))
+      return n;
+  }
+  return -1;
+}
+
+
 /* Store LOCAL labels for a macro definition */
-static void store_macro_locals(char *macro_name, struct local_label *local_list)
+static void store_macro_locals(const char *macro_name,
+                               struct local_label *local_list)
 {
-  struct macro_local_map *map;
-  struct local_label *src_local;
-  struct local_label *dst_local;
-  struct local_label **dst_tail;
+  struct macro_locals *ml;
+  struct local_label *local;
+  hashdata data;
+  unsigned i;
+  int n;
 
   /* Don't store if no LOCAL labels */
   if (local_list == NULL)
     return;
 
-  /* Allocate new mapping entry */
-  map = mymalloc(sizeof(struct macro_local_map));
-  map->macro_name = mystrdup(macro_name);
-  map->local_list = NULL;
-  dst_tail = &map->local_list;
+  ml = mymalloc(sizeof(struct macro_locals));
+  for (ml->num = 0, local = local_list; local != NULL; local = local->next)
+    ml->num++;
+  ml->names = mymalloc(ml->num * sizeof(const char *));
+  ml->lens = mymalloc(ml->num * sizeof(int));
+  for (ml->mask = 7; ml->mask < (unsigned)ml->num * 2; ml->mask = ml->mask * 2 + 1);
+  ml->slots = mycalloc((ml->mask + 1) * sizeof(int));
 
-  /* Copy LOCAL label list (just the declared_name, not unique_name) */
-  for (src_local = local_list; src_local != NULL; src_local = src_local->next) {
-    dst_local = mymalloc(sizeof(struct local_label));
-    dst_local->declared_name = mystrdup(src_local->declared_name);
-    dst_local->unique_name = NULL;  /* Will be generated per invocation */
-    dst_local->next = NULL;
-    *dst_tail = dst_local;
-    dst_tail = &dst_local->next;
+  /* keep the order of the list, the first of equal names is found */
+  for (n = 0, local = local_list; local != NULL; local = local->next, n++) {
+    ml->names[n] = intern_name(local->declared_name);
+    ml->lens[n] = strlen(local->declared_name);
+    for (i = local_hash(ml->names[n], ml->lens[n]) & ml->mask;
+         ml->slots[i] != 0; i = (i + 1) & ml->mask);
+    ml->slots[i] = n + 1;
   }
 
-  /* Add to head of list */
-  map->next = macro_local_head;
-  macro_local_head = map;
+  /* a redefined macro replaces its LOCAL labels */
+  if (macro_locals_hash == NULL)
+    macro_locals_hash = new_hashtable(MACLOCHTABSIZE);
+  macro_name = intern_name(macro_name);
+  if (nocase ? find_name_nc(macro_locals_hash, macro_name, &data) :
+               find_name(macro_locals_hash, macro_name, &data))
+    rem_hashentry(macro_locals_hash, macro_name, nocase);
+  data.ptr = ml;
+  add_hashentry(macro_locals_hash, macro_name, data, nocase);
+  last_noloc_id = ~0UL;
 }
 
 
-/* Get LOCAL label list for a macro */
-static struct local_label *get_macro_locals(char *macro_name)
+/* Get LOCAL labels for a macro */
+static struct macro_locals *get_macro_locals(const char *macro_name)
 {
-  struct macro_local_map *map;
+  hashdata data;
 
-  for (map = macro_local_head; map != NULL; map = map->next) {
-    if (nocase) {
-      if (!stricmp(map->macro_name, macro_name))
-        return map->local_list;
-    }
-    else {
-      if (!strcmp(map->macro_name, macro_name))
-        return map->local_list;
-    }
-  }
+  if (macro_locals_hash == NULL)
+    return NULL;
+  if (nocase ? find_name_nc(macro_locals_hash, macro_name, &data) :
+               find_name(macro_locals_hash, macro_name, &data))
+    return data.ptr;
   return NULL;
 }
 
@@ -483,80 +492,90 @@ static void finalize_current_macro_locals(void)
 }
 
 
-/* Generate per-invocation LOCAL label substitutions */
-static void generate_invocation_locals(source *src)
+static void add_invocation(struct invocation_locals *inv)
 {
-  struct local_label *macro_local;
-  struct local_subst *subst;
-  struct local_subst **subst_tail;
-  struct invocation_locals *inv_locals;
-  char unique[16];
+  struct invocation_locals **old = invocation_table;
+  unsigned long oldmask = invocation_mask;
+  unsigned long i,j;
 
-  /* Get LOCAL labels for this macro */
-  if (src->macro == NULL)
-    return;
+  if (invocation_table == NULL || invocation_count*2 >= invocation_mask) {
+    /* grow the table and rehash */
+    invocation_mask = invocation_table ? invocation_mask*2 + 1 : 0xff;
+    invocation_table = mycalloc((invocation_mask + 1) *
+                                sizeof(struct invocation_locals *));
+    if (old != NULL) {
+      for (i = 0; i <= oldmask; i++) {
+        if (old[i] != NULL) {
+          for (j = old[i]->src_id & invocation_mask; invocation_table[j];
+               j = (j + 1) & invocation_mask);
+          invocation_table[j] = old[i];
+        }
+      }
+      myfree(old);
+    }
+  }
+  for (j = inv->src_id & invocation_mask; invocation_table[j];
+       j = (j + 1) & invocation_mask);
+  invocation_table[j] = inv;
+  invocation_count++;
+}
+
+
+/* Return the LOCAL label substitutions of a macro invocation, which are
+   generated on first use, or NULL when the macro has no LOCAL labels */
+static struct invocation_locals *invocation_locals(source *src)
+{
+  struct invocation_locals *inv;
+  struct macro_locals *ml;
+  char unique[16];
+  unsigned long j;
+  int n;
 
-  macro_local = get_macro_locals(src->macro->name);
-  if (macro_local == NULL)
-    return;  /* No LOCAL labels for this macro */
+  if (src->macro == NULL || src->id == last_noloc_id)
+    return NULL;
+  if (last_invocation != NULL && last_invocation->src_id == src->id)
+    return last_invocation;
 
   /* Check if we already generated substitutions for this invocation */
-  for (inv_locals = invocation_locals_head; inv_locals != NULL; inv_locals = inv_locals->next) {
-    if (inv_locals->src_id == src->id)
-      return;  /* Already generated */
+  if (invocation_table != NULL) {
+    for (j = src->id & invocation_mask; (inv = invocation_table[j]) != NULL;
+         j = (j + 1) & invocation_mask) {
+      if (inv->src_id == src->id)
+        return last_invocation = inv;
+    }
   }
 
-  /* Create new invocation locals entry */
-  inv_locals = mymalloc(sizeof(struct invocation_locals));
-  inv_locals->src_id = src->id;
-  inv_locals->subst_list = NULL;
-  subst_tail = &inv_locals->subst_list;
+  /* Get LOCAL labels for this macro */
+  if ((ml = get_macro_locals(src->macro->name)) == NULL) {
+    last_noloc_id = src->id;
+    return NULL;  /* No LOCAL labels for this macro */
+  }
+
+  inv = mymalloc(sizeof(struct invocation_locals));
+  inv->src_id = src->id;
+  inv->locals = ml;
+  inv->unique_names = mymalloc(ml->num * sizeof(const char *));
 
   /* Generate unique names for each LOCAL label */
-  for (; macro_local != NULL; macro_local = macro_local->next) {
+  for (n = 0; n < ml->num; n++) {
     /* Use _Lnnnn format (L for LOCAL) to match valid identifier syntax */
     sprintf(unique, "_L%04lu", local_label_counter++);
-
-    subst = mymalloc(sizeof(struct local_subst));
-    subst->declared_name = mystrdup(macro_local->declared_name);
-    subst->unique_name = mystrdup(unique);
-    subst->next = NULL;
-
-    *subst_tail = subst;
-    subst_tail = &subst->next;
+    inv->unique_names[n] = intern_name(unique);
   }
-
-  /* Add to head of list */
-  inv_locals->next = invocation_locals_head;
-  invocation_locals_head = inv_locals;
+  add_invocation(inv);
+  return last_invocation = inv;
 }
 
 
 /* Find LOCAL label substitution for current invocation */
-static char *find_invocation_local(source *src, char *name, int len)
+static const char *find_invocation_local(source *src, const char *name, int len)
 {
-  struct invocation_locals *inv_locals;
-  struct local_subst *subst;
+  struct invocation_locals *inv;
+  int n;
 
-  /* Find substitutions for this invocation */
-  for (inv_locals = invocation_locals_head; inv_locals != NULL; inv_locals = inv_locals->next) {
-    if (inv_locals->src_id == src->id) {
-      /* Found the right invocation - now find the label */
-      for (subst = inv_locals->subst_list; subst != NULL; subst = subst->next) {
-        if (nocase) {
-          if (strlen(subst->declared_name) == len &&
-              !strnicmp(subst->declared_name, name, len))
-            return subst->unique_name;
-        }
-        else {
-          if (strlen(subst->declared_name) == len &&
-              !strncmp(subst->declared_name, name, len))
-            return subst->unique_name;
-        }
-      }
-      break;
-    }
-  }
+  if ((inv = invocation_locals(src)) != NULL &&
+      (n = find_macro_local(inv->locals, name, len)) >= 0)
+    return inv->unique_names[n];
   return NULL;
 }
 
@@ -564,18 +583,15 @@ static char *find_invocation_local(source *src, char *name, int len)
 /* Substitute LOCAL label name if we're in a macro and this is a LOCAL label */
 static char *substitute_local_label(char *labname)
 {
-  char *unique;
+  const char *unique;
 
   if (cur_src == NULL || cur_src->macro == NULL)
     return labname;  /* Not in a macro */
 
-  /* Generate LOCAL label substitutions if needed */
-  generate_invocation_locals(cur_src);
-
   /* Check if this label name is a LOCAL label */
   unique = find_invocation_local(cur_src, labname, strlen(labname));
   if (unique != NULL)
-    return unique;  /* Use unique name */
+    return (char *)unique;  /* Use unique name */
 
   return labname;  /* Not a LOCAL label, use as-is */
 }
@@ -584,7 +600,7 @@ static char *substitute_local_label(char *labname)
 static void handle_m80_local(char *s)
 {
   char *name;
-  char *macro_name_to_use = NULL;
+  const char *macro_name_to_use = NULL;
 
   /* LOCAL can be encountered in two contexts:
      1. During macro DEFINITION (rare - if LOCAL is outside macro body)
@@ -3353,38 +3369,33 @@ char *parse_macro_arg(struct macro *m,char *s,
 
 
 /* expands arguments and special escape codes into macro context */
-int expand_macro(source *src,char **line,char *d,int dlen)
+/* Check if we're on a LOCAL directive line by examining the source text */
+static int local_directive_line(source *src, char *p)
 {
-  int nc = 0;
-  char *s = *line;
-  char *varname;
-  int varlen;
-  int in_local_directive = 0;
+  char *check;
 
-  /* Check if we're on a LOCAL directive line by examining the source text
-     Find the start of the current line in the source */
-  if (src && src->macro && src->text) {
-    char *line_start = *line;
-    char *check;
+  /* Scan backwards to find start of line (after newline or at text start) */
+  while (p > src->text && *(p-1) != '\n' && *(p-1) != '\r')
+    p--;
 
-    /* Scan backwards to find start of line (after newline or at text start) */
-    while (line_start > src->text && *(line_start-1) != '\n' && *(line_start-1) != '\r')
-      line_start--;
+  /* Skip leading whitespace */
+  check = p;
+  while (*check == ' ' || *check == '\t')
+    check++;
 
-    /* Skip leading whitespace */
-    check = line_start;
-    while (*check == ' ' || *check == '\t')
-      check++;
+  /* Check if line starts with LOCAL directive */
+  return (nocase ? !strnicmp(check, "local", 5) : !strncmp(check, "local", 5)) &&
+         (check[5] == ' ' || check[5] == '\t' || check[5] == '\0');
+}
 
-    /* Check if line starts with LOCAL directive */
-    if ((nocase ? !strnicmp(check, "local", 5) : !strncmp(check, "local", 5)) &&
-        (check[5] == ' ' || check[5] == '\t' || check[5] == '\0')) {
-      in_local_directive = 1;
-    }
-  }
 
-  /* Generate LOCAL label substitutions for this invocation (if not already done) */
-  generate_invocation_locals(src);
+int expand_macro(source *src,char **line,char *d,int dlen)
+{
+  int nc = 0;
+  char *s = *line;
+  char *varname;
+  int varlen;
+  struct invocation_locals *inv;
 
   /* Check for IRP/IRPC iteration variable first */
   if (src->irpname) {
@@ -3412,11 +3423,14 @@ int expand_macro(source *src,char **line,char *d,int dlen)
     }
   }
 
-  /* Check if this identifier is a LOCAL label (but NOT on LOCAL directive lines) */
-  if (src->macro && !in_local_directive && ISIDSTART(*s)) {
+  /* Check if this identifier is a LOCAL label (but NOT on LOCAL directive
+     lines), when the macro has any */
+  if (ISIDSTART(*s) && (s == src->text || !ISIDCHAR(*(s-1))) &&
+      (inv = invocation_locals(src)) != NULL && !local_directive_line(src, s)) {
     char *labname = s;
     int lablen = 0;
-    char *unique;
+    const char *unique = NULL;
+    int n;
 
     while (ISIDCHAR(*s)) {
       lablen++;
@@ -3424,7 +3438,8 @@ int expand_macro(source *src,char **line,char *d,int dlen)
     }
 
     /* Look up in current invocation's LOCAL label map */
-    unique = find_invocation_local(src, labname, lablen);
+    if ((n = find_macro_local(inv->locals, labname, lablen)) >= 0)
+      unique = inv->unique_names[n];
     if (unique != NULL) {
       int unique_len = strlen(unique);
       /* Substitute with unique name */
@@ -3628,6 +3643,7 @@ int init_syntax(void)
   nocase_macros = 1;
 
   dirhash = new_hashtable(0x1800);
+  dirhash->name = "directives";
   for (i=0; i<dir_cnt; i++) {
     data.idx = i;
     add_hashentry(dirhash,directives[i].name,data,1);  /* directives always case-insensitive */
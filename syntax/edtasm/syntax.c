@@ -2748,6 +2748,7 @@ int init_syntax(void)
      Use -nocase flag to enable case-insensitive mode per EDTASM+ spec */
 
   dirhash = new_hashtable(0x1800);
+  dirhash->name = "directives";
   for (i=0; i<dir_cnt; i++) {
     data.idx = i;
     add_hashentry(dirhash,directives[i].name,data,1);  /* directives always case-insensitive */
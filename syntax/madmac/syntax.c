@@ -1091,6 +1091,7 @@ int init_syntax(void)
   hashdata data;
 
   dirhash = new_hashtable(0x800);
+  dirhash->name = "directives";
   for (i=0; i<dir_cnt; i++) {
     data.idx = i;
     add_hashentry(dirhash,directives[i].name,data,1);  /* case insensitive */
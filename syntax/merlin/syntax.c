@@ -82,11 +82,15 @@ static char inl_lab_name[8];
 /* Merlin three-tier label system */
 static const char *merlin_last_global_label = NULL;  /* Last global label for :LABEL local labels */
 
-/* Variable labels (]LABEL) - mutable labels with backward-only references */
+/* Variable labels (]LABEL) - mutable labels with backward-only references.
+   Each definition is a new version. Label versions need their own symbol,
+   because references point to it. Equate versions all share the slot
+   symbol, because a reference to an expression symbol copies its tree. */
 struct varlabel {
   char *name;              /* Original ]LABEL name (with ] prefix) */
-  char *unique_name;       /* Current unique name (unid_NNNN) */
-  char *pending_name;      /* Pending unique name for deferred update */
+  const char *unique_name; /* Current unique name (unid_NNNN), interned */
+  const char *pending_name;  /* Pending unique name for deferred update */
+  const char *slot_name;   /* Name of the shared equate symbol, or NULL */
   int definition_count;    /* Number of times this variable has been defined */
 };
 
@@ -99,6 +103,8 @@ static int merlin_file_type = -1;        /* ProDOS file type (TYP directive) */
 static int merlin_aux_type = -1;         /* ProDOS auxiliary type (AUX directive) */
 static int merlin_cycle_counting = 0;    /* CYC directive - cycle counting flag */
 static char merlin_output_filename[256] = "";  /* SAV directive - output filename */
+static int merlin_seg_files = 0;         /* -dsk: DSK/SAV write segment files */
+static unsigned long merlin_seg_idx = 0; /* first section of current segment */
 
 /* USR directive metadata for RW18 disk format (crackle compatibility) */
 static int merlin_usr_valid = 0;         /* Flag: USR directive was processed */
@@ -112,8 +118,10 @@ static struct varlabel *find_or_create_varlabel(const char *name, int len)
   hashdata data;
   struct varlabel *vl;
 
-  if (varlabel_hash == NULL)
+  if (varlabel_hash == NULL) {
     varlabel_hash = new_hashtable(MAXMACPARAMS * 16);  /* reasonable initial size */
+    varlabel_hash->name = "variable labels";
+  }
 
   /* Try to find existing variable label */
   if (find_namelen_nc(varlabel_hash, name, len, &data))
@@ -124,6 +132,7 @@ static struct varlabel *find_or_create_varlabel(const char *name, int len)
   vl->name = cnvstr(name, len);
   vl->unique_name = NULL;  /* Will be set on first definition */
   vl->pending_name = NULL;
+  vl->slot_name = NULL;
   vl->definition_count = 0;
 
   /* Add to hash table - use case insensitive (1) to match find_namelen_nc */
@@ -133,7 +142,7 @@ static struct varlabel *find_or_create_varlabel(const char *name, int len)
   return vl;
 }
 
-static char *get_varlabel_unique_name(const char *name, int len)
+static const char *get_varlabel_unique_name(const char *name, int len)
 {
   struct varlabel *vl = find_or_create_varlabel(name, len);
 
@@ -143,34 +152,41 @@ static char *get_varlabel_unique_name(const char *name, int len)
   if (vl->unique_name == NULL) {
     char unique_name[32];
     snprintf(unique_name, sizeof(unique_name), "unid_%d", varlabel_counter++);
-    vl->unique_name = mystrdup(unique_name);
+    vl->unique_name = intern_name(unique_name);
   }
 
   return vl->unique_name;
 }
 
-/* Prepare a new variable label definition - creates new unique name but
-   doesn't update unique_name yet (deferred until finalize_varlabel) */
-static char *prepare_varlabel_definition(const char *name, int len)
+static const char *new_varlabel_name(void)
 {
-  struct varlabel *vl = find_or_create_varlabel(name, len);
   char unique_name[32];
 
+  snprintf(unique_name, sizeof(unique_name), "unid_%d", varlabel_counter++);
+  return intern_name(unique_name);
+}
+
+/* Prepare a new variable label definition - selects the name of the new
+   version but doesn't update unique_name yet (deferred until
+   finalize_varlabel) */
+static const char *prepare_varlabel_definition(struct varlabel *vl, int equate)
+{
   /* For the first definition, if unique_name already exists (from forward ref),
      use it. Only create a new name for redefinitions. */
   if (vl->definition_count == 0 && vl->unique_name != NULL) {
     /* This is the first definition, but we have a forward reference.
        Use the existing unique_name (don't replace it). */
-    if (vl->pending_name)
-      myfree(vl->pending_name);
-    vl->pending_name = mystrdup(vl->unique_name);
+    vl->pending_name = vl->unique_name;
+  }
+  else if (equate) {
+    /* Equates reuse the slot symbol, a LUP doesn't leave dead symbols */
+    if (vl->slot_name == NULL)
+      vl->slot_name = new_varlabel_name();
+    vl->pending_name = vl->slot_name;
   }
   else {
-    /* New definition (or first definition without forward ref) */
-    snprintf(unique_name, sizeof(unique_name), "unid_%d", varlabel_counter++);
-    if (vl->pending_name)
-      myfree(vl->pending_name);
-    vl->pending_name = mystrdup(unique_name);
+    /* New label definition (or first definition without forward ref) */
+    vl->pending_name = new_varlabel_name();
   }
 
   /* Track this as the pending variable label */
@@ -184,8 +200,6 @@ static void finalize_varlabel(void)
 {
   if (pending_varlabel && pending_varlabel->pending_name) {
     /* Move pending_name to unique_name */
-    if (pending_varlabel->unique_name)
-      myfree(pending_varlabel->unique_name);
     pending_varlabel->unique_name = pending_varlabel->pending_name;
     pending_varlabel->pending_name = NULL;
     pending_varlabel->definition_count++;
@@ -193,12 +207,61 @@ static void finalize_varlabel(void)
   pending_varlabel = NULL;
 }
 
-/* Legacy define_varlabel for immediate update (non-EQU contexts) */
-static char *define_varlabel(const char *name, int len)
+/* Define a new equate version of the pending variable label */
+static symbol *new_varlabel_equate(const char *name, expr *tree, int equ)
+{
+  symbol *sym = find_symbol(name);
+
+  if (sym == NULL || sym->type != EXPRESSION ||
+      name != pending_varlabel->slot_name)
+    return equ ? new_equate(name, tree) : new_abs(name, tree);
+
+  /* slot symbol: earlier references hold a copy of the old expression */
+  free_expr(sym->expr);
+  sym->flags &= ~EQUATE;
+  sym = new_abs(name, tree);
+  if (equ)
+    sym->flags |= EQUATE;
+  return sym;
+}
+
+/* Precompiled headers: save the variable labels with their current
+   versions, and the counter, which is saved under an empty name */
+void save_syntax_state(void (*put)(const char *,const char *,const char *,
+                                   uint32_t,void *),void *arg)
+{
+  struct varlabel *vl;
+  hashentry *e;
+  size_t i;
+
+  put(emptystr, NULL, NULL, varlabel_counter, arg);
+  if (varlabel_hash == NULL)
+    return;
+  for (i=0; i<varlabel_hash->size; i++) {
+    for (e=varlabel_hash->entries[i]; e!=NULL; e=e->next) {
+      vl = (struct varlabel *)e->data.ptr;
+      put(vl->name, vl->unique_name, vl->slot_name,
+          vl->definition_count, arg);
+    }
+  }
+}
+
+/* restore a variable label, or the counter, from a precompiled header */
+void load_syntax_state(const char *name, const char *unique,
+                       const char *slot, uint32_t num)
 {
-  char *result = prepare_varlabel_definition(name, len);
-  finalize_varlabel();
-  return result;
+  struct varlabel *vl;
+
+  if (*name == '\0') {
+    if ((int)num > varlabel_counter)
+      varlabel_counter = (int)num;
+    return;
+  }
+  vl = find_or_create_varlabel(name, strlen(name));
+  vl->unique_name = unique ? intern_name(unique) : NULL;
+  vl->pending_name = NULL;
+  vl->slot_name = slot ? intern_name(slot) : NULL;
+  vl->definition_count = (int)num;
 }
 
 int igntrail;  /* ignore everything after a blank in the operand field */
@@ -379,8 +442,6 @@ static void handle_data_mod(char *s,int size,expr *tree)
       op = new_operand();
       s = skip_operand(0,s);
       if (parse_operand(opstart,s-opstart,op,DATA_OPERAND(size))) {
-        atom *a;
-
 #if defined(VASM_CPU_650X) || defined(VASM_CPU_Z80) || defined(VASM_CPU_6800)
         if (mod != NULL) {
           expr *tmpvalue = *mod = op->value;
@@ -388,9 +449,7 @@ static void handle_data_mod(char *s,int size,expr *tree)
           free_expr(tmpvalue);
         }
 #endif
-        a = new_datadef_atom(OPSZ_BITS(size),op);
-        a->align = 1;
-        add_atom(0,a);
+        add_datadef(OPSZ_BITS(size),op);
       }
       else
         syntax_error(8);  /* invalid data operand */
@@ -1996,8 +2055,7 @@ static void handle_use(char *s)
 static void handle_rel(char *s)
 {
   /* Merlin REL directive - generate relocatable output */
-  /* This would typically set flags for the output module */
-  /* For now, just acknowledge and ignore */
+  /* LNK format is not supported, use an object output format instead */
   eol(s);
 }
 
@@ -2009,7 +2067,11 @@ static void handle_dsk(char *s)
   strbuf *name;
 
   if (name = parse_name(0,&s)) {
-    /* Set output file name - for now just ignore */
+    if (merlin_seg_files) {
+      /* the following code is written to this file */
+      merlin_seg_idx = start_output_target(mystrdup(name->str),
+                                           dsect_active);
+    }
     eol(s);
   }
 }
@@ -2313,6 +2375,13 @@ static void handle_sav(char *s)
   if (len > 0 && len < sizeof(merlin_output_filename) - 1) {
     strncpy(merlin_output_filename, name, len);
     merlin_output_filename[len] = '\0';
+
+    if (merlin_seg_files) {
+      /* the code since the last DSK or SAV is saved to this file,
+         the following code goes to the main output until the next one */
+      new_output_target(mystrdup(merlin_output_filename), merlin_seg_idx);
+      merlin_seg_idx = start_output_target(NULL, dsect_active);
+    }
   }
 
   eol(s);
@@ -2953,33 +3022,28 @@ struct {
 
 int dir_cnt = sizeof(directives) / sizeof(directives[0]);
 
+/* directive indices of EM and ENDR, for the <<< and --^ delimiters */
+static int em_dir,endr_dir;
+
 
 /* checks for a valid directive, and return index when found, -1 otherwise */
 static int check_directive(char **line)
 {
   char *s,*name;
-  hashdata data;
+  int idx;
 
   s = skip(*line);
 
   /* Merlin: Special handling for <<< end macro delimiter */
   if (s[0] == '<' && s[1] == '<' && s[2] == '<') {
-    name = "em";  /* treat <<< as EM directive (handle_endm) */
     *line = s + 3;
-    if (find_name_nc(dirhash, name, &data)) {
-      return data.idx;
-    }
-    return -1;
+    return em_dir;  /* treat <<< as EM directive (handle_endm) */
   }
 
   /* Merlin: Special handling for --^ end loop delimiter */
   if (s[0] == '-' && s[1] == '-' && s[2] == '^') {
-    name = "endr";  /* treat --^ as ENDR directive (handle_endr) */
     *line = s + 3;
-    if (find_name_nc(dirhash, name, &data)) {
-      return data.idx;
-    }
-    return -1;
+    return endr_dir;  /* treat --^ as ENDR directive (handle_endr) */
   }
 
   /* Handle . prefix for directives (optional in Merlin, for compatibility) */
@@ -3000,10 +3064,10 @@ static int check_directive(char **line)
       s++;
   }
 
-  if (!find_namelen_nc(dirhash,name,s-name,&data))
+  if (!(find_idclass(name,s-name,&idx) & IDC_DIRECTIVE))
     return -1;
   *line = s;
-  return data.idx;
+  return idx;
 }
 
 
@@ -3143,9 +3207,11 @@ enum {
 };
 
 
-static char *parse_label_field(char **start,int *asntype)
+static const char *parse_label_field(char **start,int *asntype)
 {
-  char *s,*name;
+  char *s;
+  const char *name;
+  struct varlabel *vl = NULL;  /* variable label to be defined */
   int spaced;  /* potential label is spaced and needs a ':' or '=' */
   int is_special_label = 0;  /* Flag for :LABEL or ]LABEL */
 
@@ -3230,7 +3296,8 @@ static char *parse_label_field(char **start,int *asntype)
       if (asntype) {
         /* Prepare variable label definition - deferred until after expression is evaluated
            This allows ]VAR = ]VAR+1 to work correctly (referencing OLD value) */
-        name = prepare_varlabel_definition(namestart, nameend - namestart);
+        vl = find_or_create_varlabel(namestart, nameend - namestart);
+        name = vl->name;  /* replaced once the kind of definition is known */
         is_special_label = 1;  /* Mark as special label */
       }
       else {
@@ -3300,6 +3367,8 @@ static char *parse_label_field(char **start,int *asntype)
     }
   }
 
+  if (vl != NULL && name != NULL)
+    name = prepare_varlabel_definition(vl, *asntype != ASN_NONE);
   return name;
 }
 
@@ -3357,12 +3426,13 @@ static char *read_next_statement(void)
 
 void parse(void)
 {
-  char *s,*line,*inst,*labname;
+  char *s,*line,*inst;
+  const char *labname;
   char *ext[MAX_QUALIFIERS?MAX_QUALIFIERS:1];
   char *op[MAX_OPERANDS];
   int ext_len[MAX_QUALIFIERS?MAX_QUALIFIERS:1];
   int op_len[MAX_OPERANDS];
-  int ext_cnt,op_cnt,inst_len,asn_type;
+  int ext_cnt,op_cnt,inst_len,asn_type,idc;
   instruction *ip;
 
 #ifdef STATEMENT_DELIMITER
@@ -3370,6 +3440,7 @@ void parse(void)
 #else
   while (line = read_next_line()) {
 #endif
+
     /* Merlin: Preprocess <<< to EOM for core vasm compatibility */
     /* vasm's macro reader requires alphanumeric directive names */
     {
@@ -3441,6 +3512,8 @@ void parse(void)
             finalize_varlabel();  /* Finalize any pending variable label */
             continue;
           }
+          else if (pending_varlabel)
+            label = new_varlabel_equate(labname,parse_expr_tmplab(&s),1);
           else
             label = new_equate(labname,parse_expr_tmplab(&s));
         }
@@ -3448,6 +3521,8 @@ void parse(void)
           /* SET allows redefinitions */
           if (*labname == current_pc_char)
             syntax_error(10);  /* identifier expected */
+          else if (pending_varlabel)
+            label = new_varlabel_equate(labname,parse_expr_tmplab(&s),0);
           else
             label = new_abs(labname,parse_expr_tmplab(&s));
         }
@@ -3496,9 +3571,7 @@ void parse(void)
         /* and is not a variable label (which have internal names like unid_N) */
         if (labname[0] != ' ' && labname[0] != ':' && !is_varlabel) {
           /* This is a global label - update context for :LABEL scoping */
-          if (merlin_last_global_label)
-            myfree((void *)merlin_last_global_label);
-          merlin_last_global_label = mystrdup(labname);
+          merlin_last_global_label = intern_name(labname);
         }
       }
 
@@ -3578,9 +3651,15 @@ void parse(void)
       syntax_error(2);  /* no space before operands */
     s = skip(s);
 
-    if (execute_macro(inst,inst_len,ext,ext_len,ext_cnt,s))
+#ifdef NO_MACRO_QUALIFIERS
+    idc = IDC_MACRO | IDC_STRUCT;  /* macro name may include qualifiers */
+#else
+    idc = find_idclass(inst,inst_len,NULL);
+#endif
+    if ((idc & IDC_MACRO) &&
+        execute_macro(inst,inst_len,ext,ext_len,ext_cnt,s))
       continue;
-    if (execute_struct(inst,inst_len,s))
+    if ((idc & IDC_STRUCT) && execute_struct(inst,inst_len,s))
       continue;
 
     /* read operands, terminated by comma or blank (unless in parentheses) */
@@ -3755,11 +3834,11 @@ int expand_macro(source *src,char **line,char *d,int dlen)
       s++;
     }
     else {
-      /* Not a valid Merlin escape - output ] and continue */
+      /* Not a valid Merlin escape - output ] and continue after it,
+         like in a variable label ]NAME */
       if (dlen >= 1) {
         *d = ']';
         nc = 1;
-        s--;  /* Back up to reprocess this character */
       }
       else
         nc = -1;
@@ -4051,7 +4130,7 @@ strbuf *get_local_label(int n,char **start)
   else if (*s == ']' && ISIDSTART(*(s+1))) {
     char *namestart = s;  /* Include the ] prefix in lookup */
     char *nameend = s + 1;
-    char *unique;
+    const char *unique;
     static strbuf varbuf[EXPBUFNO+1];
     char *p;
     int ulen;
@@ -4108,12 +4187,16 @@ int init_syntax(void)
   allow_trailing_comments = 1;
 
   dirhash = new_hashtable(0x1000);
+  dirhash->name = "directives";
   for (i=0; i<dir_cnt; i++) {
     data.idx = i;
     add_hashentry(dirhash,directives[i].name,data,1);  /* case insensitive */
+    add_idclass(directives[i].name,IDC_DIRECTIVE,i);
   }
   if (debug && dirhash->collisions)
     fprintf(stderr,"*** %d directive collisions!!\n",dirhash->collisions);
+  em_dir = find_name_nc(dirhash,"em",&data) ? data.idx : -1;
+  endr_dir = find_name_nc(dirhash,"endr",&data) ? data.idx : -1;
 
   cond_init();
   set_internal_abs(REPTNSYM,-1); /* reserve the REPTN symbol */
@@ -4154,6 +4237,8 @@ int syntax_args(char *p)
     dot_idchar = 1;
   else if (!strcmp(p,"-sect"))
     sect_directives = 1;
+  else if (!strcmp(p,"-dsk"))
+    merlin_seg_files = 1;
   else
     return 0;
 
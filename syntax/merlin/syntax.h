@@ -49,6 +49,9 @@ extern int igntrail;
 /* Enable optional # prefix in data directives (dfb #EXPR) for Merlin compatibility */
 #define SYNTAX_SUPPORTS_SCASM_OPS
 
+/* variable labels are saved in precompiled headers */
+#define SYNTAX_PCH_STATE
+
 /* symbol which contains the current rept-endr iteration count */
 #define REPTNSYM "__RPTCNT"
 
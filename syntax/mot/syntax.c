@@ -711,12 +711,17 @@ static void handle_data(char *s,int size)
       op = new_operand();
       s = skip_operand(s);
       if (parse_operand(opstart,s-opstart,op,DATA_OPERAND(size))) {
+#if defined(VASM_CPU_650X) || defined(VASM_CPU_Z80) || \
+    defined(VASM_CPU_6800) || defined(VASM_CPU_6809)
+        add_datadef(OPSZ_BITS(size),op);  /* DATA_ALIGN() is always 1 */
+#else
         atom *a;
 
         a = new_datadef_atom(OPSZ_BITS(size),op);
         if (!align_data)
           a->align = 1;
         add_atom(0,a);
+#endif
       }
       else
         syntax_error(8);  /* invalid data operand */
@@ -2769,6 +2774,7 @@ int init_syntax(void)
   else avail = 0;
 
   dirhash = new_hashtable(0x1800);
+  dirhash->name = "directives";
   for (i=0; i<dir_cnt; i++) {
     if ((directives[i].flags & avail) == avail) {
       data.idx = i;
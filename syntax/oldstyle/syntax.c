@@ -2136,6 +2136,7 @@ int init_syntax(void)
   hashdata data;
 
   dirhash = new_hashtable(0x1000);
+  dirhash->name = "directives";
   for (i=0; i<dir_cnt; i++) {
     data.idx = i;
     add_hashentry(dirhash,directives[i].name,data,1);  /* case insensitive */
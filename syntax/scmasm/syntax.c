@@ -62,7 +62,7 @@ static char local_modif_name[] = "_";  /* ._ for abyte directive */
 static char current_pc_str[2];
 
 static int autoexport,parse_end,nocprefix,nointelsuffix;
-static int astcomment,dot_idchar,sect_directives;
+static int astcomment,dot_idchar,sect_directives,tf_targets;
 static taddr orgmode = ~0;
 static section *last_alloc_sect;
 static taddr dsect_offs;
@@ -284,8 +284,6 @@ static void handle_data_mod(char *s,int size,expr *tree)
       op = new_operand();
       s = skip_operand(0,s);
       if (parse_operand(opstart,s-opstart,op,DATA_OPERAND(size))) {
-        atom *a;
-
 #if defined(VASM_CPU_650X) || defined(VASM_CPU_Z80) || defined(VASM_CPU_6800)
         if (mod != NULL) {
           expr *tmpvalue = *mod = op->value;
@@ -293,9 +291,7 @@ static void handle_data_mod(char *s,int size,expr *tree)
           free_expr(tmpvalue);
         }
 #endif
-        a = new_datadef_atom(OPSZ_BITS(size),op);
-        a->align = 1;
-        add_atom(0,a);
+        add_datadef(OPSZ_BITS(size),op);
       }
       else
         syntax_error(8);  /* invalid data operand */
@@ -531,9 +527,7 @@ static void handle_taddr(char *s)
     op = new_operand();
     s = skip_operand(0, s);
     if (parse_operand(opstart, s - opstart, op, DATA_OPERAND(size))) {
-      atom *a = new_datadef_atom(OPSZ_BITS(size), op);
-      a->align = 1;
-      add_atom(0, a);
+      add_datadef(OPSZ_BITS(size), op);
     }
     else {
       syntax_error(8);  /* invalid data operand */
@@ -2221,7 +2215,8 @@ static void handle_noop(char *s)
   /* Silently ignore the directive and its arguments */
 }
 
-/* SCASM: Handle .TF directive - extract target binary path */
+/* SCASM: Handle .TF directive - extract target binary path.
+   With -tf the following code is written to this file. */
 static void handle_tf(char *s)
 {
   char *start, *end;
@@ -2237,10 +2232,13 @@ static void handle_tf(char *s)
   end = s;
 
   /* Store the target file path */
-  if (scmasm_target_file)
+  if (scmasm_target_file && !tf_targets)
     myfree(scmasm_target_file);
   scmasm_target_file = cnvstr(start, end - start);
 
+  if (tf_targets)
+    start_output_target(scmasm_target_file,dsect_active);
+
   eol(s);
 }
 
@@ -2494,7 +2492,7 @@ int dir_cnt = sizeof(directives) / sizeof(directives[0]);
 static int check_directive(char **line)
 {
   char *s,*name;
-  hashdata data;
+  int idx;
 
   s = skip(*line);
 
@@ -2516,10 +2514,10 @@ static int check_directive(char **line)
       s++;
   }
 
-  if (!find_namelen_nc(dirhash,name,s-name,&data))
+  if (!(find_idclass(name,s-name,&idx) & IDC_DIRECTIVE))
     return -1;
   *line = s;
-  return data.idx;
+  return idx;
 }
 
 
@@ -2878,7 +2876,7 @@ void parse(void)
   char *op[MAX_OPERANDS];
   int ext_len[MAX_QUALIFIERS?MAX_QUALIFIERS:1];
   int op_len[MAX_OPERANDS];
-  int ext_cnt,op_cnt,inst_len,asn_type;
+  int ext_cnt,op_cnt,inst_len,asn_type,idc;
   instruction *ip;
 
 #ifdef STATEMENT_DELIMITER
@@ -2886,6 +2884,7 @@ void parse(void)
 #else
   while (line = read_next_line()) {
 #endif
+
     /* SCASM: Skip optional line numbers at start of line (e.g., "1000  .OR $2000") */
     /* Line numbers are all digits followed by whitespace */
     s = line;
@@ -3185,9 +3184,15 @@ void parse(void)
       s = skip(s);  /* Normal mode - skip all whitespace */
     }
 
-    if (execute_macro(inst,inst_len,ext,ext_len,ext_cnt,s))
+#ifdef NO_MACRO_QUALIFIERS
+    idc = IDC_MACRO | IDC_STRUCT;  /* macro name may include qualifiers */
+#else
+    idc = find_idclass(inst,inst_len,NULL);
+#endif
+    if ((idc & IDC_MACRO) &&
+        execute_macro(inst,inst_len,ext,ext_len,ext_cnt,s))
       continue;
-    if (execute_struct(inst,inst_len,s))
+    if ((idc & IDC_STRUCT) && execute_struct(inst,inst_len,s))
       continue;
 
     /* read operands, terminated by comma or blank (unless in parentheses) */
@@ -3706,9 +3711,11 @@ int init_syntax(void)
   nocprefix = 1;
 
   dirhash = new_hashtable(0x1000);
+  dirhash->name = "directives";
   for (i=0; i<dir_cnt; i++) {
     data.idx = i;
     add_hashentry(dirhash,directives[i].name,data,1);  /* case insensitive */
+    add_idclass(directives[i].name,IDC_DIRECTIVE,i);
   }
   if (debug && dirhash->collisions)
     fprintf(stderr,"*** %d directive collisions!!\n",dirhash->collisions);
@@ -3752,6 +3759,8 @@ int syntax_args(char *p)
     dot_idchar = 1;
   else if (!strcmp(p,"-sect"))
     sect_directives = 1;
+  else if (!strcmp(p,"-tf"))
+    tf_targets = 1;
   else
     return 0;
 
@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+"""
+Test DSK/SAV segment files with the -dsk option
+
+With -dsk, DSK sends the following code to the named file, and SAV saves
+the code since the last DSK or SAV to the named file. Other code goes to
+the main output file given with -o. This test validates that:
+  - each file receives the code of its segments
+  - segments saved twice to the same name are written into one file
+  - ORG and DUM between the segments do not move code into other files
+  - the main output file gets the code outside of the segments only,
+    and is not created when there is no such code
+"""
+
+import os
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                ".."))
+from output_files import OutputFileTests
+
+tests = OutputFileTests("Merlin DSK/SAV Segment File Tests",
+                        "../../vasm6502_merlin", ["-dsk"])
+
+tests.case("DSK and SAV", """
+        ORG $2000
+        DSK ONE
+        LDA #1
+        SAV ONE
+        DSK TWO
+        LDA #2
+        SAV TWO
+""", {"ONE": b"\xa9\x01", "TWO": b"\xa9\x02", "main.bin": None})
+
+tests.case("two SAV to the same file", """
+        ORG $2000
+        LDA #1
+        SAV ONE
+        LDA #2
+        SAV TWO
+        LDA #3
+        SAV ONE
+""", {"ONE": b"\xa9\x01\x00\x00\xa9\x03", "TWO": b"\xa9\x02",
+      "main.bin": None})
+
+tests.case("ORG between segments", """
+        ORG $2000
+        DSK ONE
+        LDA #1
+        SAV ONE
+        ORG $4000
+        DSK TWO
+        JMP *
+        SAV TWO
+""", {"ONE": b"\xa9\x01", "TWO": b"\x4c\x00\x40", "main.bin": None})
+
+tests.case("DUM inside a segment", """
+        ORG $2000
+        DSK ONE
+        LDA #1
+        DUM $80
+PTR     DS  2
+        DEND
+        STA PTR
+        SAV ONE
+""", {"ONE": b"\xa9\x01\x85\x80", "main.bin": None})
+
+tests.case("DUM between segments", """
+        ORG $2000
+        LDA #1
+        SAV ONE
+        DUM $80
+PTR     DS  2
+        DEND
+        STA PTR
+        SAV TWO
+""", {"ONE": b"\xa9\x01", "TWO": b"\x85\x80", "main.bin": None})
+
+tests.case("code after the last SAV", """
+        ORG $2000
+        DSK ONE
+        LDA #1
+        SAV ONE
+        LDA #2
+""", {"ONE": b"\xa9\x01", "main.bin": b"\xa9\x02"})
+
+tests.finish()
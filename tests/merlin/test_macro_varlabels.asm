@@ -0,0 +1,35 @@
+* Variable Labels in Macros
+* Tests: ]NAME inside a macro body, next to parameters ]1-]8
+
+        ORG   $8000
+
+* Test 1: variable label equated to a parameter
+Store   MAC
+]DST    EQU   ]1
+        STA   ]DST
+        <<<
+
+        Store $0300
+        Store $0301
+
+* Test 2: variable labels as operands and in expressions
+Copy    MAC
+]SRC    EQU   ]1
+]LEN    EQU   ]2
+        LDY   #]LEN-1
+]LOOP   LDA   ]SRC,Y
+        STA   $0400,Y
+        DEY
+        BPL   ]LOOP
+        <<<
+
+        Copy  $1000;8
+        Copy  $2000;4
+
+* Test 3: ]] escape next to a variable label
+Ref     MAC
+]]X     =     ]1
+        DFB   ]X
+        <<<
+
+        Ref   $55
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""
+Test precompiled headers with Merlin sources
+
+A header is assembled with -pch-out into an image, which is loaded with
+-pch-in when assembling the main source. The header is skipped then. This
+test validates that:
+  - the main source assembles to the same output with and without image
+  - macros from a USE library work after loading the image
+  - variable labels (]VAR) defined in a header keep their value and can
+    be redefined in the main source
+  - a header is skipped when included by another path to the same file
+"""
+
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+VASM = os.path.abspath("../../vasm6502_merlin")
+failed = 0
+passed = 0
+
+print("Merlin Precompiled Header Tests")
+print("=" * 40)
+print()
+
+
+def assemble(tmp, args):
+    try:
+        return subprocess.run([VASM, "-quiet"] + args, cwd=tmp,
+                              capture_output=True, text=True, timeout=10)
+    except subprocess.TimeoutExpired:
+        return subprocess.CompletedProcess(args, -1, "", "timed out")
+
+
+def test_case(name, header, source, expected=None, files=(), dirs=()):
+    """Build an image of header, assemble source with and without it"""
+    global failed, passed
+
+    print(f"Test: {name} ... ", end="", flush=True)
+
+    with tempfile.TemporaryDirectory() as tmp:
+        for fname in files:
+            shutil.copy(fname, tmp)
+        for dname in dirs:
+            os.mkdir(os.path.join(tmp, dname))
+        if header is not None:
+            with open(os.path.join(tmp, "defs.s"), "w") as f:
+                f.write(header)
+            hname = "defs.s"
+        else:
+            hname = os.path.basename(files[0])
+        with open(os.path.join(tmp, "main.s"), "w") as f:
+            f.write(source)
+
+        error = None
+        outputs = []
+        result = assemble(tmp, ["-pch-out=defs.pch", hname])
+        if result.returncode != 0:
+            error = "writing the image failed: " + result.stderr.strip()
+        else:
+            for opts in (["-pch-in=defs.pch"], []):
+                out = "with.bin" if opts else "without.bin"
+                result = assemble(tmp, opts + ["-Fbin", "-o", out, "main.s"])
+                if result.returncode != 0:
+                    error = ("with" if opts else "without") + \
+                            " image: " + result.stderr.strip()
+                    break
+                with open(os.path.join(tmp, out), "rb") as f:
+                    outputs.append(f.read())
+
+    if error is None and outputs[0] != outputs[1]:
+        error = f"outputs differ: {outputs[0].hex()} vs {outputs[1].hex()}"
+    if error is None and expected is not None and outputs[0] != expected:
+        error = f"output is {outputs[0].hex()}, expected {expected.hex()}"
+
+    if error is None:
+        print("PASS")
+        passed += 1
+    else:
+        print(f"FAIL ({error})")
+        failed += 1
+
+
+test_case("macro library", None, """
+        ORG $2000
+        USE macro_library.asm
+COPY1   MEMCPY $1000;$2000;16
+FILL1   MEMFILL $3000;$EA;8
+SUM     ADD16 $10;$12
+COPY2   MEMCPY $1100;$2100;4
+""", files=("macro_library.asm",))
+
+test_case("variable label from a header", """
+]CNT    =     3
+""", """
+        ORG $2000
+        PUT defs.s
+]CNT    =     ]CNT+1
+        DFB   ]CNT
+""", expected=b"\x04")
+
+test_case("variable label redefined in a header", """
+]CNT    =     1
+]CNT    =     ]CNT+1
+MAX     =     ]CNT*2
+""", """
+        ORG $2000
+        PUT defs.s
+        DFB   ]CNT,MAX
+]CNT    =     ]CNT+1
+        DFB   ]CNT
+""", expected=b"\x02\x04\x03")
+
+test_case("variable labels in a loop after a header", """
+]N      =     0
+""", """
+        ORG $2000
+        PUT defs.s
+        LUP   3
+]N      =     ]N+1
+        DFB   ]N
+        --^
+""", expected=b"\x01\x02\x03")
+
+test_case("header included as ./defs.s", """
+FOO     =     $12
+PUTFOO  MAC
+        DFB   FOO,]1
+        <<<
+""", """
+        ORG $2000
+        PUT ./defs.s
+        PUTFOO $34
+""", expected=b"\x12\x34")
+
+test_case("header included as ./sub/../defs.s", """
+FOO     =     $12
+""", """
+        ORG $2000
+        PUT ./sub/../defs.s
+        DFB   FOO
+""", expected=b"\x12", dirs=("sub",))
+
+print()
+print("=" * 40)
+print(f"Results: {passed} passed, {failed} failed")
+print("=" * 40)
+sys.exit(1 if failed else 0)
@@ -0,0 +1,78 @@
+"""
+Shared harness for tests of the output files of one assembler run
+
+A test assembles a source in an empty directory and compares the files
+written there with the expected contents. Used by the target file tests
+of the syntax modules (tests/scmasm/test_target_files.py and
+tests/merlin/test_dsk.py).
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+
+
+class OutputFileTests:
+    def __init__(self, title, vasm, options):
+        """vasm is the assembler relative to the test directory, options
+        are passed before -Fbin -o main.bin"""
+        self.vasm = os.path.abspath(vasm)
+        self.options = options
+        self.passed = 0
+        self.failed = 0
+        print(title)
+        print("=" * 40)
+        print()
+
+    def check(self, tmp, expected):
+        """Returns an error message, or None when all files match"""
+        for fname, data in expected.items():
+            path = os.path.join(tmp, fname)
+            if data is None:
+                if os.path.exists(path):
+                    return f"{fname} was created"
+            elif not os.path.exists(path):
+                return f"{fname} is missing"
+            else:
+                with open(path, "rb") as f:
+                    actual = f.read()
+                if actual != data:
+                    return f"{fname} contains {actual.hex()}, " \
+                           f"expected {data.hex()}"
+        return None
+
+    def case(self, name, source, expected):
+        """Assemble source, expected maps file names to their contents,
+        or to None for files which must not exist"""
+        print(f"Test: {name} ... ", end="", flush=True)
+
+        with tempfile.TemporaryDirectory() as tmp:
+            with open(os.path.join(tmp, "test.s"), "w") as f:
+                f.write(source)
+            try:
+                result = subprocess.run(
+                    [self.vasm, "-quiet"] + self.options +
+                    ["-Fbin", "-o", "main.bin", "test.s"],
+                    cwd=tmp, capture_output=True, text=True, timeout=10
+                )
+                if result.returncode != 0:
+                    error = "assembly failed: " + result.stderr.strip()
+                else:
+                    error = self.check(tmp, expected)
+            except subprocess.TimeoutExpired:
+                error = "timed out"
+
+        if error is None:
+            print("PASS")
+            self.passed += 1
+        else:
+            print(f"FAIL ({error})")
+            self.failed += 1
+
+    def finish(self):
+        print()
+        print("=" * 40)
+        print(f"Results: {self.passed} passed, {self.failed} failed")
+        print("=" * 40)
+        sys.exit(1 if self.failed else 0)
@@ -0,0 +1,357 @@
+#!/usr/bin/env python3
+"""
+vasm Benchmark Runner
+
+Generates parameterized stress sources for a cpu/syntax combination,
+assembles them and reports wall time, peak RSS, resolver passes and the
+time spent in each assembler phase (taken from -timing).
+
+Usage:
+    python3 tests/run_bench.py <syntax> -c <cpu> [-a assembler] [-s scale]
+
+Examples:
+    python3 tests/run_bench.py merlin -c 6502
+    python3 tests/run_bench.py mot -c m68k -s 4 -o bench.json
+"""
+
+import os
+import sys
+import json
+import time
+import random
+import argparse
+import tempfile
+import subprocess
+from pathlib import Path
+
+
+REPORT_VERSION = 1
+
+# cpu specific instructions: an unconditional branch or jump (which is
+# optimized by the backend, when it supports it) and a one-word filler
+CPU_CONFIG = {
+    '6502':  {'branch': 'jmp',  'nop': 'nop', 'org': 0x1000},
+    '6800':  {'branch': 'jmp',  'nop': 'nop', 'org': 0x1000},
+    '6809':  {'branch': 'jmp',  'nop': 'nop', 'org': 0x1000},
+    'z80':   {'branch': 'jp',   'nop': 'nop', 'org': 0x1000},
+    'm68k':  {'branch': 'bra',  'nop': 'nop', 'org': 0},
+    'x86':   {'branch': 'jmp',  'nop': 'nop', 'org': 0},
+    'ppc':   {'branch': 'b',    'nop': 'nop', 'org': 0},
+    'arm':   {'branch': 'b',    'nop': 'nop', 'org': 0},
+}
+
+# syntax specific source formats
+SYNTAX_CONFIG = {
+    'mot': {
+        'label': '{0}:', 'ind': '\t', 'equ': '{0}\tequ\t{1}',
+        'byte': 'dc.b', 'space': 'ds.b\t{0}', 'org': 'org\t${0:x}',
+        'macro': '{0}\tmacro', 'endm': '\tendm', 'arg': '\\1',
+        'include': '\tinclude\t"{0}"', 'hex': None,
+    },
+    'std': {
+        'label': '{0}:', 'ind': '\t', 'equ': '\t.set\t{0},{1}',
+        'byte': '.byte', 'space': '.space\t{0}', 'org': '.org\t0x{0:x}',
+        'macro': '\t.macro\t{0} p', 'endm': '\t.endm', 'arg': '\\p',
+        'include': '\t.include\t"{0}"', 'hex': None,
+    },
+    'oldstyle': {
+        'label': '{0}:', 'ind': '\t', 'equ': '{0}\tequ\t{1}',
+        'byte': 'byte', 'space': 'ds\t{0}', 'org': 'org\t${0:x}',
+        'macro': '{0}\tmacro', 'endm': '\tendm', 'arg': '\\1',
+        'include': '\tinclude\t"{0}"', 'hex': None,
+    },
+    'edtasm-m80': {
+        'label': '{0}:', 'ind': '\t', 'equ': '{0}\tequ\t{1}',
+        'byte': 'defb', 'space': 'defs\t{0}', 'org': 'org\t{0:x}h',
+        'macro': '{0}\tmacro', 'endm': '\tendm', 'arg': '#P1',
+        'include': '\tinclude\t{0}', 'hex': None,
+    },
+    'merlin': {
+        'label': '{0}', 'ind': '\t', 'equ': '{0}\tEQU\t{1}',
+        'byte': 'DFB', 'space': 'DS\t{0}', 'org': 'ORG\t${0:X}',
+        'macro': '{0}\tMAC', 'endm': '\t<<<', 'arg': ']1',
+        'include': '\tPUT\t{0}', 'hex': 'HEX',
+    },
+    'scmasm': {
+        'label': '{0}', 'ind': '\t', 'equ': '{0}\t.EQ\t{1}',
+        'byte': '.DA', 'space': '.BS\t{0}', 'org': '.OR\t${0:X}',
+        'macro': '\t.MA\t{0}', 'endm': '\t.EM', 'arg': ']1',
+        'include': '\t.IN\t{0}', 'hex': '.HS', 'bytepfx': '#',
+        'call': '>{0}',
+    },
+}
+
+
+def data_line(syn, values):
+    """One line of byte data."""
+    pfx = syn.get('bytepfx', '')
+    return '{0}{1}\t{2}'.format(syn['ind'], syn['byte'],
+                                ','.join(pfx + str(v) for v in values))
+
+
+def gen_branches(cpu, syn, n, rnd):
+    """N labels with forward and backward branches over random gaps, which
+       forces the resolver to relax branch sizes over many passes."""
+    lines = [syn['ind'] + syn['org'].format(cpu['org'])]
+    for i in range(n):
+        lines.append(syn['label'].format('L%d' % i))
+        lines.append('{0}{1}\tL{2}'.format(syn['ind'], cpu['branch'],
+                                          rnd.randrange(n)))
+        lines.append(syn['ind'] + syn['space'].format(rnd.randrange(4, 80, 4)))
+    return lines
+
+
+def gen_equates(cpu, syn, n, rnd):
+    """A deep chain of forward-referencing equates."""
+    lines = [syn['ind'] + syn['org'].format(cpu['org'])]
+    lines.append(data_line(syn, ['E0-E1']))
+    for i in range(n):
+        lines.append(syn['equ'].format('E%d' % i, 'E%d+1' % (i + 1)))
+    lines.append(syn['equ'].format('E%d' % n, '0'))
+    return lines
+
+
+def gen_macros(cpu, syn, n, rnd):
+    """A macro expansion storm: every invocation expands a nested macro."""
+    lines = [syn['ind'] + syn['org'].format(cpu['org'])]
+    lines.append(syn['macro'].format('INNER'))
+    lines.append(data_line(syn, [syn['arg'], syn['arg']]))
+    lines.append(syn['endm'])
+    lines.append(syn['macro'].format('OUTER'))
+    call = syn['ind'] + syn.get('call', '{0}')
+    lines.append('{0}\t{1}'.format(call.format('INNER'), syn['arg']))
+    lines.append('{0}{1}'.format(syn['ind'], cpu['nop']))
+    lines.append(syn['endm'])
+    for i in range(n):
+        lines.append('{0}\t{1}'.format(call.format('OUTER'), i & 127))
+    return lines
+
+
+def gen_tables(cpu, syn, n, rnd):
+    """Large constant data tables, using HEX strings when available."""
+    lines = [syn['ind'] + syn['org'].format(cpu['org'])]
+    for i in range(n):
+        values = [rnd.randrange(256) for _ in range(16)]
+        if syn['hex'] and i & 1:
+            lines.append('{0}{1}\t{2}'.format(
+                syn['ind'], syn['hex'], ''.join('%02X' % v for v in values)))
+        else:
+            lines.append(data_line(syn, values))
+    return lines
+
+
+def gen_sections(cpu, syn, n, rnd):
+    """Many absolute ORG sections with a few labels and data each."""
+    lines = []
+    for i in range(n):
+        lines.append(syn['ind'] + syn['org'].format(cpu['org'] + i * 0x40))
+        lines.append(syn['label'].format('S%d' % i))
+        lines.append(data_line(syn, [rnd.randrange(256) for _ in range(8)]))
+        lines.append('{0}{1}'.format(syn['ind'], cpu['nop']))
+    return lines
+
+
+def gen_includes(cpu, syn, n, rnd, workdir):
+    """An include tree: a chain of nested files, each including the shared
+       leaf file several times."""
+    depth = 8
+    leaf = 'inc_leaf.s'
+    with open(os.path.join(workdir, leaf), 'w') as f:
+        for _ in range(16):
+            f.write(data_line(syn, [rnd.randrange(256) for _ in range(8)]))
+            f.write('\n')
+    per_node = max(1, n // depth)
+    for d in range(depth, 0, -1):
+        with open(os.path.join(workdir, 'inc_%d.s' % d), 'w') as f:
+            for _ in range(per_node):
+                f.write(syn['include'].format(leaf) + '\n')
+            if d < depth:
+                f.write(syn['include'].format('inc_%d.s' % (d + 1)) + '\n')
+    return [syn['ind'] + syn['org'].format(cpu['org']),
+            syn['include'].format('inc_1.s')]
+
+
+BENCHMARKS = [
+    # name, generator, base size (multiplied by scale)
+    ('branches', gen_branches, 2000),
+    ('equates', gen_equates, 2000),
+    ('macros', gen_macros, 5000),
+    ('tables', gen_tables, 20000),
+    ('sections', gen_sections, 200),
+    ('includes', gen_includes, 200),
+]
+
+
+def wait_peak_rss(proc):
+    """Wait for a process and return its exit status and its peak RSS in kB.
+       ru_maxrss of a child also covers the memory of the forking Python
+       process before the exec, so on Linux VmHWM of the child itself is
+       read from /proc instead. It has to be polled while the child runs,
+       because it is gone as soon as the child exits. Elsewhere ru_maxrss
+       is the best we have."""
+    status_file = '/proc/%d/status' % proc.pid
+    hwm = None
+    if os.path.exists(status_file):
+        while True:
+            try:
+                with open(status_file) as f:
+                    fields = [l.split() for l in f if l.startswith('VmHWM:')]
+            except OSError:
+                break
+            if not fields:
+                break  # zombie, the memory was released
+            hwm = int(fields[0][1])
+            time.sleep(0.001)
+    _, status, rusage = os.wait4(proc.pid, 0)
+    if hwm is None and not os.path.exists(status_file):
+        hwm = rusage.ru_maxrss
+    return os.waitstatus_to_exitcode(status), hwm
+
+
+def run_bench(assembler, source, workdir):
+    """Assemble a source and return wall time, peak RSS, passes, phases."""
+    timing = os.path.join(workdir, 'timing.json')
+    rstats = os.path.join(workdir, 'resolve.log')
+    errlog = os.path.join(workdir, 'stderr.log')
+    for f in (timing, rstats):
+        if os.path.exists(f):
+            os.remove(f)
+
+    cmd = [assembler, '-quiet', '-w', '-Fbin',
+           '-o', os.path.join(workdir, 'bench.bin'),
+           '-timing=' + timing, '-resolve-stats=' + rstats, source]
+    start = time.perf_counter()
+    with open(errlog, 'wb') as err:
+        proc = subprocess.Popen(cmd, cwd=workdir, stdout=subprocess.DEVNULL,
+                                stderr=err)
+        proc.returncode, rss_kb = wait_peak_rss(proc)
+    wall = time.perf_counter() - start
+    with open(errlog, 'rb') as f:
+        stderr = f.read()
+
+    result = {
+        'wall': wall,
+        'rss_kb': rss_kb,
+        'passes': 0,
+        'phases': {},
+        'ok': proc.returncode == 0,
+        'error': '',
+    }
+    if proc.returncode != 0:
+        errors = [l for l in stderr.decode(errors='replace').split('\n')
+                  if l.startswith('error ') or l.startswith('fatal ')]
+        result['error'] = errors[0] if errors else 'exit code %d' % proc.returncode
+    if os.path.exists(timing):
+        with open(timing) as f:
+            result['phases'] = json.load(f)['phases']
+    if os.path.exists(rstats):
+        with open(rstats) as f:
+            for line in f:
+                # section <passes> <fast passes> <name>
+                fields = line.split(None, 3)
+                if fields and fields[0] == 'section':
+                    result['passes'] += int(fields[1])
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Run vasm throughput benchmarks',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  %(prog)s merlin -c 6502            Benchmark vasm6502_merlin
+  %(prog)s mot -c m68k -s 4          Benchmark with four times larger sources
+  %(prog)s std -c x86 -o bench.json  Also write the report as JSON
+  %(prog)s mot -c m68k -k tmp        Keep the generated sources in tmp
+"""
+    )
+    parser.add_argument('syntax', help='Syntax module (%s)' %
+                        ', '.join(SYNTAX_CONFIG.keys()))
+    parser.add_argument('-c', '--cpu', required=True,
+                        help='CPU module (%s)' % ', '.join(CPU_CONFIG.keys()))
+    parser.add_argument('-a', '--assembler',
+                        help='Path to assembler executable')
+    parser.add_argument('-s', '--scale', type=float, default=1.0,
+                        help='Multiply the size of all generated sources')
+    parser.add_argument('-b', '--bench', action='append',
+                        help='Run only the named benchmark (may be repeated)')
+    parser.add_argument('-o', '--output',
+                        help='Write the report as JSON to this file')
+    parser.add_argument('-k', '--keep',
+                        help='Generate the sources into this directory and keep them')
+    parser.add_argument('--seed', type=int, default=1,
+                        help='Random seed for the generated sources')
+    args = parser.parse_args()
+
+    if args.syntax not in SYNTAX_CONFIG:
+        print(f"Error: Unsupported syntax module '{args.syntax}'")
+        sys.exit(1)
+    if args.cpu not in CPU_CONFIG:
+        print(f"Error: Unsupported cpu module '{args.cpu}'")
+        sys.exit(1)
+
+    root = Path(__file__).resolve().parent.parent
+    if args.assembler:
+        assembler = Path(args.assembler).resolve()
+    else:
+        assembler = (root / f"vasm{args.cpu}_{args.syntax}").resolve()
+    if not assembler.exists():
+        print(f"Error: Assembler not found: {assembler}")
+        print(f"Build it first with: make CPU={args.cpu} SYNTAX={args.syntax}")
+        sys.exit(1)
+
+    cpu = CPU_CONFIG[args.cpu]
+    syn = SYNTAX_CONFIG[args.syntax]
+    phases = ('parse', 'resolve', 'assemble', 'output')
+    report = {'version': REPORT_VERSION, 'cpu': args.cpu,
+              'syntax': args.syntax, 'scale': args.scale, 'results': []}
+    failed = 0
+
+    print(f"# vasm benchmark report v{REPORT_VERSION}")
+    print(f"# assembler: {assembler.name}  cpu: {args.cpu}  "
+          f"syntax: {args.syntax}  scale: {args.scale:g}")
+    print('{:<10} {:>8} {:>8} {:>7} {:>8} {:>8} {:>8} {:>8} {:>7}'.format(
+          'bench', 'size', 'wall_s', 'rss_kb', 'passes',
+          *[p + '_s' for p in phases]).rstrip())
+
+    with tempfile.TemporaryDirectory() as tmpdir:
+        workdir = args.keep or tmpdir
+        os.makedirs(workdir, exist_ok=True)
+        for name, gen, size in BENCHMARKS:
+            if args.bench and name not in args.bench:
+                continue
+            n = max(1, int(size * args.scale))
+            rnd = random.Random(args.seed)
+            if gen is gen_includes:
+                lines = gen(cpu, syn, n, rnd, workdir)
+            else:
+                lines = gen(cpu, syn, n, rnd)
+            source = os.path.join(workdir, f"bench_{name}.s")
+            with open(source, 'w') as f:
+                f.write('\n'.join(lines) + '\n')
+
+            r = run_bench(str(assembler), source, workdir)
+            r['bench'] = name
+            r['size'] = n
+            report['results'].append(r)
+            if not r['ok']:
+                failed += 1
+                print(f"{name:<10} {n:>8} FAILED: {r['error']}")
+                continue
+            print('{:<10} {:>8} {:>8.3f} {:>8} {:>7} {:>8.3f} {:>8.3f} '
+                  '{:>8.3f} {:>8.3f}'.format(
+                  name, n, r['wall'],
+                  '-' if r['rss_kb'] is None else r['rss_kb'], r['passes'],
+                  *[r['phases'].get(p, 0.0) for p in phases]))
+
+    if args.output:
+        with open(args.output, 'w') as f:
+            json.dump(report, f, indent=2, sort_keys=True)
+            f.write('\n')
+
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
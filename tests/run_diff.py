@@ -0,0 +1,303 @@
+#!/usr/bin/env python3
+"""
+vasm Differential Test Runner
+
+Assembles a corpus with a reference assembler and with the assembler under
+test and compares the outputs byte-for-byte, together with the exit codes
+and the diagnostics. The corpus consists of the test sources of the syntax
+module, any additional files given on the command line and random
+instruction streams, which are generated from the cpu's mnemonic table.
+
+The reference may be another build (e.g. of the last release), or the same
+assembler with different options, to compare two code paths of one build.
+
+Usage:
+    python3 tests/run_diff.py <syntax> -c <cpu> -r <reference> [options] [paths]
+
+Examples:
+    python3 tests/run_diff.py merlin -c 6502 -r /tmp/old/vasm6502_merlin
+    python3 tests/run_diff.py mot -c m68k --ref-opts=-no-opt -n 50
+"""
+
+import os
+import re
+import sys
+import shlex
+import random
+import argparse
+import tempfile
+import subprocess
+from pathlib import Path
+
+from run_bench import SYNTAX_CONFIG
+
+
+# test sources of each syntax module
+CORPUS = {
+    'scmasm': ['tests/scmasm'],
+    'merlin': ['tests/merlin'],
+    'oldstyle': ['tests/oldstyle'],
+    'edtasm-m80': ['tests/edtasm-m80'],
+    'edtasm': ['tests/edtasm'],
+}
+SOURCE_SUFFIXES = ('.s', '.asm')
+
+# operands for the random instruction streams, '@' is replaced by a label
+# and '$' hex constants are converted for syntax modules using '0x'
+OPERANDS = {
+    '6502': ['', '#$12', '$12', '$1234', '$12,x', '$12,y', '$1234,x',
+             '$1234,y', '($12,x)', '($12),y', '($12)', '($1234)', 'a',
+             '@', '@,x', '@,y', '(@)', '#<@', '#>@'],
+    '6800': ['', '#$12', '$12', '$1234', '5,x', '@', '#@'],
+    '6809': ['', '#$12', '#$1234', '$12', '$1234', ',x', '5,x', '-5,y',
+             '$1234,u', ',x+', ',x++', ',-y', '[$1234]', '[,x]', 'a,b',
+             'x,y', 'd', '@', '@,pcr', '#@'],
+    'z80': ['', 'a', 'b', '(hl)', 'hl', 'bc', 'de', 'ix', 'a,b', 'a,(hl)',
+            'a,$12', 'b,$12', 'hl,$1234', 'hl,bc', 'a,(ix+5)', '(ix+5)',
+            '(iy-3),a', '($1234),a', 'a,($1234)', 'nz,@', 'z,@', '@', '0,a',
+            '7,(hl)', '(c),a'],
+    'm68k': ['', 'd0', 'a0', 'd0,d1', 'a0,a1', '#1,d0', '#$1234,d2',
+             '(a0),d1', 'd0,(a1)+', '-(a2),d3', '8(a0),d0', '(a0)+,(a1)+',
+             '(4,a0,d1.w),d2', '$1234.w,d0', '$12345678,d0', 'd0-d3/a0,-(sp)',
+             '@', '@(pc),a0', '@,a0', '#@,d0'],
+    'x86': ['', '%eax', '%ax', '%al', '%eax,%ebx', '$0x5,%eax', '$0x1234,%cx',
+            '(%eax),%ebx', '8(%ebp),%eax', '%eax,-4(%esp)', '(%esi,%ecx,4),%edx',
+            '@', '@(%ebx),%eax'],
+    'ppc': ['', 'r3', 'r3,r4', 'r3,r4,r5', 'r3,r4,5', 'r3,8(r1)', 'r3,-4(r1)',
+            'cr0,r3,r4', 'f1,f2,f3', '@', 'cr1,@'],
+    'arm': ['', 'r0', 'r0,r1', 'r0,r1,r2', 'r0,r1,#5', 'r0,#1', 'r0,[r1]',
+            'r0,[r1,#4]', 'r0,[r1],#4', 'r0,r1,lsl #2', 'r0,{r1,r2}',
+            'r0!,{r1-r3}', '@', 'r0,@'],
+}
+
+
+def find_project_root():
+    """Find the project root directory (where Makefile is)."""
+    current = Path(__file__).resolve().parent
+    while current != current.parent:
+        if (current / 'Makefile').exists() and (current / 'make.rules').exists():
+            return current
+        current = current.parent
+    return Path.cwd()
+
+
+def read_mnemonics(root, cpu):
+    """Mnemonic names from the cpu's mnemonic table."""
+    table = root / 'cpus' / cpu / 'opcodes.h'
+    if not table.exists():
+        table = root / 'cpus' / cpu / 'cpu.c'
+    names = []
+    pattern = re.compile(r'^\s*\{?\s*"([A-Za-z][A-Za-z0-9_.]*)"\s*,\s*\{')
+    with open(table, errors='replace') as f:
+        for line in f:
+            m = pattern.match(line)
+            if m and m.group(1) not in names:
+                names.append(m.group(1))
+    return names
+
+
+def gen_stream(mnemonics, operands, syn, org, nlines, rnd):
+    """A random instruction stream with labels to branch to."""
+    nlabels = max(1, nlines // 8)
+    lines = [syn['ind'] + syn['org'].format(org)]
+    label = 0
+    for i in range(nlines):
+        if label < nlabels and rnd.randrange(8) == 0:
+            lines.append(syn['label'].format('L%d' % label))
+            label += 1
+        opnd = rnd.choice(operands).replace('@', 'L%d' % rnd.randrange(nlabels))
+        if '0x' in syn['org']:
+            opnd = re.sub(r'\$([0-9A-Fa-f]+)\b', r'0x\1', opnd)
+        lines.append('{0}{1}\t{2}'.format(syn['ind'], rnd.choice(mnemonics),
+                                          opnd).rstrip())
+    while label < nlabels:
+        lines.append(syn['label'].format('L%d' % label))
+        label += 1
+    return lines
+
+
+def assemble(assembler, opts, source, fmt, output):
+    """Assemble a source and return exit code, diagnostics and output."""
+    if os.path.exists(output):
+        os.remove(output)
+    cmd = [assembler, '-quiet', '-F' + fmt, '-o', output] + opts + [source]
+    try:
+        result = subprocess.run(cmd, cwd=os.path.dirname(source),
+                                capture_output=True, timeout=60)
+    except subprocess.TimeoutExpired:
+        return (None, 'timed out', b'')
+    data = b''
+    if os.path.exists(output):
+        with open(output, 'rb') as f:
+            data = f.read()
+    diag = result.stdout.decode(errors='replace') + \
+           result.stderr.decode(errors='replace')
+    return (result.returncode, diag, data)
+
+
+def error_lines(diag, source):
+    """Line numbers of the main source with an error."""
+    name = re.escape(os.path.basename(source))
+    return set(int(n) for n in re.findall(
+        r'^error \d+ in line (\d+) of "(?:.*[/\\])?' + name + '"', diag, re.M))
+
+
+def operand_field(line):
+    """Operand field of a generated instruction line."""
+    fields = line.split('\t')
+    return fields[2] if len(fields) > 2 else ''
+
+
+def prune_stream(assembler, opts, source, lines, fmt, output, rounds=8):
+    """Remove lines the reference assembler rejects, so most of a random
+       stream assembles and reaches the resolver and the output module."""
+    for _ in range(rounds):
+        with open(source, 'w') as f:
+            f.write('\n'.join(lines) + '\n')
+        _, diag, _ = assemble(assembler, opts + ['-maxerrors=0'], source,
+                              fmt, output)
+        bad = error_lines(diag, source)
+        # undefined symbols are reported without a line number
+        undef = re.findall(r'undefined symbol <([^>]+)>', diag)
+        if not bad and not undef:
+            break
+        undef = re.compile(r'\b(%s)\b' % '|'.join(map(re.escape, undef))) \
+                if undef else None
+        lines = [l for i, l in enumerate(lines) if i + 1 not in bad and
+                 not (i > 0 and undef and undef.search(operand_field(l)))]
+    with open(source, 'w') as f:
+        f.write('\n'.join(lines) + '\n')
+    return lines
+
+
+def compare(ref, new):
+    """Describe the first difference between two assembler results."""
+    if ref[0] != new[0]:
+        return 'exit code %s, reference %s' % (new[0], ref[0])
+    if ref[2] != new[2]:
+        if len(ref[2]) != len(new[2]):
+            return 'output size %d, reference %d' % (len(new[2]), len(ref[2]))
+        offs = next(i for i in range(len(ref[2])) if ref[2][i] != new[2][i])
+        return 'output differs at offset 0x%x' % offs
+    if ref[1] != new[1]:
+        return 'diagnostics differ'
+    return None
+
+
+def collect_sources(root, syntax, paths):
+    """Test sources of the syntax module and the given files/directories."""
+    sources = []
+    dirs = [root / d for d in CORPUS.get(syntax, [])] + \
+           [Path(p).resolve() for p in paths]
+    for d in dirs:
+        if d.is_file():
+            sources.append(d)
+        elif d.is_dir():
+            sources += sorted(p for p in d.iterdir()
+                              if p.suffix in SOURCE_SUFFIXES)
+    return sources
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Compare vasm output against a reference',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  %(prog)s merlin -c 6502 -r old/vasm6502_merlin   Compare against another build
+  %(prog)s mot -c m68k --ref-opts=-no-opt          Compare two option sets
+  %(prog)s std -c arm -r old/vasmarm_std -n 100    Use 100 random streams
+  %(prog)s oldstyle -c z80 -r ref src/ -k tmp      Add sources, keep streams
+"""
+    )
+    parser.add_argument('syntax', help='Syntax module (%s)' %
+                        ', '.join(SYNTAX_CONFIG.keys()))
+    parser.add_argument('paths', nargs='*',
+                        help='Additional source files or directories')
+    parser.add_argument('-c', '--cpu', required=True,
+                        help='CPU module (%s)' % ', '.join(OPERANDS.keys()))
+    parser.add_argument('-a', '--assembler',
+                        help='Path to the assembler under test')
+    parser.add_argument('-r', '--ref',
+                        help='Path to the reference assembler '
+                             '(default: the assembler under test)')
+    parser.add_argument('--ref-opts', default='',
+                        help='Additional options for the reference')
+    parser.add_argument('--new-opts', default='',
+                        help='Additional options for the assembler under test')
+    parser.add_argument('-F', '--formats', default='bin,vobj',
+                        help='Comma separated output formats (default: bin,vobj)')
+    parser.add_argument('-n', '--streams', type=int, default=20,
+                        help='Number of random instruction streams')
+    parser.add_argument('-l', '--lines', type=int, default=500,
+                        help='Instructions per random stream')
+    parser.add_argument('-k', '--keep',
+                        help='Generate the streams into this directory and keep them')
+    parser.add_argument('--seed', type=int, default=1,
+                        help='Random seed for the generated streams')
+    parser.add_argument('-v', '--verbose', action='store_true',
+                        help='Show every compared source')
+    args = parser.parse_args()
+
+    root = find_project_root()
+    if args.assembler:
+        new_asm = Path(args.assembler).resolve()
+    else:
+        new_asm = (root / f"vasm{args.cpu}_{args.syntax}").resolve()
+    ref_asm = Path(args.ref).resolve() if args.ref else new_asm
+    for asm in (new_asm, ref_asm):
+        if not asm.exists():
+            print(f"Error: Assembler not found: {asm}")
+            sys.exit(1)
+    ref_opts = shlex.split(args.ref_opts)
+    new_opts = shlex.split(args.new_opts)
+    if ref_asm == new_asm and ref_opts == new_opts:
+        print("Note: reference and assembler under test are identical, "
+              "only checking for deterministic output")
+    formats = [f for f in args.formats.split(',') if f]
+
+    sources = collect_sources(root, args.syntax, args.paths)
+    mismatches = 0
+    compared = 0
+
+    with tempfile.TemporaryDirectory() as tmpdir:
+        workdir = os.path.abspath(args.keep or tmpdir)
+        os.makedirs(workdir, exist_ok=True)
+        ref_out = os.path.join(tmpdir, 'ref.out')
+        new_out = os.path.join(tmpdir, 'new.out')
+
+        # random instruction streams from the cpu's mnemonic table
+        if args.streams > 0:
+            if args.cpu not in OPERANDS or args.syntax not in SYNTAX_CONFIG:
+                print(f"Note: no random streams for {args.cpu}/{args.syntax}")
+            else:
+                mnemonics = read_mnemonics(root, args.cpu)
+                rnd = random.Random(args.seed)
+                for i in range(args.streams):
+                    lines = gen_stream(mnemonics, OPERANDS[args.cpu],
+                                       SYNTAX_CONFIG[args.syntax], 0x1000,
+                                       args.lines, rnd)
+                    source = os.path.join(workdir, 'stream_%03d.s' % i)
+                    prune_stream(str(ref_asm), ref_opts, source, lines,
+                                 formats[0], ref_out)
+                    sources.append(Path(source))
+
+        for source in sources:
+            for fmt in formats:
+                ref = assemble(str(ref_asm), ref_opts, str(source), fmt, ref_out)
+                new = assemble(str(new_asm), new_opts, str(source), fmt, new_out)
+                diff = compare(ref, new)
+                compared += 1
+                if diff:
+                    mismatches += 1
+                    print(f"MISMATCH {source} (-F{fmt}): {diff}")
+                elif args.verbose:
+                    print(f"ok       {source} (-F{fmt})")
+
+    print(f"{compared} compared, {mismatches} mismatches "
+          f"({len(sources)} sources, formats: {', '.join(formats)})")
+    sys.exit(1 if mismatches else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+"""
+Test .TF target files with the -tf option
+
+With -tf, the code following a .TF directive is written to the named
+target file, instead of the main output file given with -o. This test
+validates that:
+  - each target file receives the code of its ranges
+  - ranges of the same target file are written into one file
+  - the main output file gets the code before the first .TF only,
+    and is not created when there is no such code
+"""
+
+import os
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                ".."))
+from output_files import OutputFileTests
+
+tests = OutputFileTests("SCASM .TF Target File Tests",
+                        "../../vasm6502_scmasm", ["-tf"])
+
+tests.case("two targets", """
+        .OR $0800
+        .TF ONE.BIN
+        LDA #1
+        .TF TWO.BIN
+        LDA #2
+""", {"ONE.BIN": b"\xa9\x01", "TWO.BIN": b"\xa9\x02", "main.bin": None})
+
+tests.case("same target twice", """
+        .OR $0800
+        .TF ONE.BIN
+        LDA #1
+        .TF TWO.BIN
+        LDA #2
+        .TF ONE.BIN
+        LDA #3
+""", {"ONE.BIN": b"\xa9\x01\x00\x00\xa9\x03", "TWO.BIN": b"\xa9\x02",
+      "main.bin": None})
+
+tests.case("code before the first target", """
+        .OR $0800
+        LDA #0
+        .TF ONE.BIN
+        LDA #1
+""", {"main.bin": b"\xa9\x00", "ONE.BIN": b"\xa9\x01"})
+
+tests.case("labels across targets", """
+        .OR $0800
+        .TF ONE.BIN
+START   JMP NEXT
+        .TF TWO.BIN
+NEXT    JMP START
+""", {"ONE.BIN": b"\x4c\x03\x08", "TWO.BIN": b"\x4c\x00\x08",
+      "main.bin": None})
+
+tests.finish()
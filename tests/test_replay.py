@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+"""
+Test the replay of repetitions
+
+The remaining iterations of a REPT block may be replayed by copying the
+atoms of a watched iteration, instead of parsing the body again. This is
+only done for CPU modules which define REPLICATE_OPERANDS in cpu.h.
+
+Each case assembles a repetition and the same source with the body
+written out, and expects both outputs to be identical. The -stats report
+tells whether iterations were replayed:
+  - "replay" expects replayed iterations
+  - "parse" expects that all iterations were parsed
+
+Run from the repository root or from tests/, after building the
+assemblers: vasmm68k_mot, vasm6809_mot, vasmz80_mot, vasm6502_oldstyle
+and vasm6502_merlin.
+"""
+
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+failed = 0
+passed = 0
+skipped = 0
+
+print("Repetition Replay Tests")
+print("=" * 40)
+print()
+
+
+def assemble(vasm, tmp, name, source):
+    """Assemble source, return the output and the replayed iterations"""
+    src = os.path.join(tmp, name + ".s")
+    out = os.path.join(tmp, name + ".bin")
+    with open(src, "w") as f:
+        f.write(source)
+    result = subprocess.run(
+        [vasm, "-quiet", "-Fbin", "-stats", "-o", out, src],
+        capture_output=True, text=True, timeout=30
+    )
+    if result.returncode != 0:
+        return None, 0, result.stderr.strip()
+    with open(out, "rb") as f:
+        data = f.read()
+    m = re.search(r"replayed iterations\s+(\d+)", result.stdout + result.stderr)
+    return data, int(m.group(1)) if m else 0, ""
+
+
+def test_case(name, vasm, expected, count, body, head="", tail="",
+              rept="\trept {0}\n", endr="\tendr\n"):
+    """Compare a repetition of body with count copies of it"""
+    global failed, passed, skipped
+
+    print(f"Test: {name} ... ", end="", flush=True)
+    path = os.path.join(ROOT, vasm)
+    if not os.path.exists(path):
+        print(f"SKIP ({vasm} not built)")
+        skipped += 1
+        return
+
+    with tempfile.TemporaryDirectory() as tmp:
+        rsrc = head + rept.format(count) + body + endr + tail
+        usrc = head + "".join(body.replace("{n}", str(i))
+                              for i in range(count)) + tail
+        rsrc = rsrc.replace("{n}", "REPTN")
+        rout, replays, err = assemble(path, tmp, "rept", rsrc)
+        uout, _, uerr = assemble(path, tmp, "unrolled", usrc)
+
+    if rout is None or uout is None:
+        print(f"FAIL (assembly failed: {err or uerr})")
+        failed += 1
+    elif rout != uout:
+        print(f"FAIL (output differs: {len(rout)} vs {len(uout)} bytes)")
+        failed += 1
+    elif (replays > 0) != (expected == "replay"):
+        print(f"FAIL (expected {expected}, {replays} iterations replayed)")
+        failed += 1
+    else:
+        print("PASS")
+        passed += 1
+
+
+# m68k optimizes operands in place, so its atoms must not be copied
+test_case("m68k optimized move in a section", "vasmm68k_mot", "parse", 20,
+          "\tmove.l #$80,d0\n", head="\tsection code,code\n")
+test_case("m68k before the first section", "vasmm68k_mot", "parse", 20,
+          "\tmove.l #$80,d0\n\tadd.l #1,d1\n")
+test_case("m68k data and branches", "vasmm68k_mot", "parse", 16,
+          "\tdc.w 1,2,3\n\tbne.s *+4\n\tnop\n",
+          head="\tsection code,code\n")
+
+# 6809 frees its operands after assembling them
+test_case("6809 indexed", "vasm6809_mot", "parse", 20,
+          "\tleax 1,x\n\tlda ,y+\n", head="\torg $1000\n")
+
+test_case("z80 indexed", "vasmz80_mot", "replay", 30,
+          "\tld a,(ix+5)\n\tld (iy-3),a\n", head="\torg $8000\n")
+test_case("z80 data", "vasmz80_mot", "replay", 30,
+          "\tdc.b 1,2,3\n\tdc.w $1234\n", head="\torg $8000\n")
+test_case("z80 counter", "vasmz80_mot", "parse", 10,
+          "\tdc.b {n}\n", head="\torg $8000\n")
+
+test_case("6502 in a section", "vasm6502_oldstyle", "replay", 50,
+          "\tlda #1\n\tsta $1000\n", head="\torg $1000\n")
+test_case("6502 before the first section", "vasm6502_oldstyle", "replay", 50,
+          "\tlda #1\n\tsta $1000\n")
+test_case("6502 data before the first section", "vasm6502_oldstyle",
+          "replay", 50, "\tbyte 1,2,3\n")
+test_case("6502 forward reference", "vasm6502_oldstyle", "replay", 20,
+          "\tjmp end\n", head="\torg $1000\n", tail="end\trts\n")
+
+test_case("6502 merlin LUP", "vasm6502_merlin", "replay", 40,
+          "\tLDA #1\n\tSTA $C000\n", head="\tORG $2000\n",
+          rept="\tLUP {0}\n", endr="\t--^\n")
+
+print()
+print("=" * 40)
+print(f"Results: {passed} passed, {failed} failed, {skipped} skipped")
+print("=" * 40)
+sys.exit(1 if failed else 0)
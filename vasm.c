@@ -4,11 +4,19 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#ifdef VASM_FUZZ
+#include <setjmp.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#endif
 
 #include "vasm.h"
 #include "osdep.h"
 #include "stabs.h"
 #include "dwarf.h"
+#include "pch.h"
 
 #define _VER "vasm 2.0e"
 const char *copyright = _VER " (c) in 2002-2025 Volker Barthelmann";
@@ -47,7 +55,7 @@ int asciiout,secname_attr,warn_unalloc_ini_dat;
 #endif
 hashtable *mnemohash;
 
-char *filename,*debug_filename;
+const char *filename,*debug_filename;
 source *cur_src;
 section *current_section,container_section;
 int num_secs;
@@ -69,11 +77,23 @@ char vasmsym_name[]="__VASM";
 
 static FILE *outfile;
 static int maxpasses=MAXPASSES;
+static char *pch_inname,*pch_outname;  /* precompiled header images */
 static section *first_section,*last_section;
 #if NOT_NEEDED
 static section *prev_sec,*prev_org;
 #endif
 
+/* additional output files, each written with a range of sections */
+struct output_target {
+  struct output_target *next;
+  const char *name;
+  unsigned long first_idx;  /* index of the first section in the range */
+  struct output_target *dest;  /* first target with the same name */
+  section *first_sec,*last_sec;
+  symbol *first_sym;
+};
+static struct output_target *first_target,*last_target;
+
 /* stack for push/pop-section directives */
 #define SECSTACKSIZE 64
 static section *secstack[SECSTACKSIZE];
@@ -85,17 +105,67 @@ static int add_uscore,dwarf,fail_on_warning;
 static int verbose=1,auto_import=1;
 static taddr sec_padding;
 
+/* -timing: phase profiler */
+enum {
+  TM_PARSE,TM_RESOLVE,TM_ASSEMBLE,TM_LISTING,TM_SYMBOLS,TM_DEPEND,TM_OUTPUT,
+  TM_PHASES
+};
+static const char *tm_names[TM_PHASES] = {
+  "parse","resolve","assemble","listing","symbols","depend","output"
+};
+static int timing;
+static char *timing_filename;
+static double tm_phase[TM_PHASES],tm_last;
+static double *tm_section;     /* resolve time per section index */
+static int *tm_passes;         /* resolve passes per section index */
+
+/* -resolve-stats: resolver convergence per section and pass */
+#define RSTATS_TOPN 10
+struct rstats {
+  struct rstats *next;
+  section *sec;
+  int passes,fastpasses,alloc;
+  unsigned long *labels;        /* labels moved in each pass */
+  unsigned long *atoms;         /* atoms resized in each pass */
+};
+static int resolve_stats;
+static char *rstats_filename;
+static struct rstats *first_rstats,*last_rstats;
+
+/* -batch: assemble many input:output pairs in parallel worker processes */
+struct batchjob {
+  struct batchjob *next;
+  char *inname,*outname;
+  FILE *out,*err;               /* output of the worker process */
+  long handle;
+};
+static int batch_mode,batch_jobs;
+static struct batchjob *first_batchjob,*last_batchjob;
+
+/* -stats: hash table and hot-path counters */
+static int hot_stats_report;
+static char *stats_filename;
+
 /* output */
 static char *output_copyright;
 static void (*write_object)(FILE *,section *,symbol *);
 static int (*output_args)(char *);
 
+#ifdef VASM_FUZZ
+static jmp_buf fuzz_env;
+static int fuzzing;
+#endif
+
 
 void leave(void)
 {
   section *sec;
   symbol *sym;
 
+#ifdef VASM_FUZZ
+  if(fuzzing)
+    longjmp(fuzz_env,1);  /* fatal error: return to the fuzzer entry */
+#endif
   if(outfile){
     fclose(outfile);
     if (errors&&outname!=NULL)
@@ -122,6 +192,206 @@ void leave(void)
     exit(EXIT_SUCCESS);
 }
 
+/* An <input>:<output> pair is split at the first colon after an existing
+   input file, so both names may contain colons. */
+static void new_batchjob(char *arg)
+{
+  struct batchjob *job;
+  char *p,*name=NULL;
+  FILE *f;
+
+  for(p=strchr(arg,':');p!=NULL;p=strchr(p+1,':')){
+    if(p==arg||*(p+1)=='\0')
+      continue;
+    name=cnvstr(arg,p-arg);
+    if(f=fopen(name,"r")){
+      fclose(f);
+      break;
+    }
+    myfree(name);
+    name=NULL;
+  }
+  if(name==NULL){
+    general_error(91,arg);
+    return;
+  }
+  job=mycalloc(sizeof(struct batchjob));
+  job->inname=name;
+  job->outname=p+1;
+  if(last_batchjob)
+    last_batchjob->next=job;
+  else
+    first_batchjob=job;
+  last_batchjob=job;
+}
+
+/* copy the output of a worker, with the input name in front of every line */
+static void copy_job_output(FILE *from,FILE *to,const char *name)
+{
+  char buf[256];
+  int bol=1;
+
+  rewind(from);
+  while(fgets(buf,sizeof(buf),from)){
+    if(bol)
+      fprintf(to,"%s: ",name);
+    fputs(buf,to);
+    bol=buf[strlen(buf)-1]=='\n';
+  }
+  if(!bol)
+    fputc('\n',to);
+  fclose(from);
+}
+
+/* Start a worker process for every batch job, with at most batch_jobs
+   running at the same time. All modules are already initialized, so the
+   workers share the tables. Returns in a worker, with inname and outname
+   set for its job. The main process exits when all jobs are done. */
+static void run_batch(void)
+{
+  struct batchjob *job,*next=first_batchjob;
+  int running=0,started=0,failed=0,jobfailed;
+  long handle;
+
+  if(batch_jobs<=0)
+    batch_jobs=num_cpus();
+  while(next||running){
+    while(next&&running<batch_jobs){
+      job=next;
+      next=job->next;
+      if(!(job->out=tmpfile())||!(job->err=tmpfile()))
+        general_error(13,"temporary file");
+      if((handle=start_job(job->out,job->err))==0){
+        inname=job->inname;
+        outname=job->outname;
+        return;  /* worker process */
+      }
+      if(handle<0){
+        if(!started)
+          general_error(90);  /* no workers at all */
+        job->handle=-1;  /* reported below, workers inherit errors */
+        fclose(job->out);
+        fclose(job->err);
+        failed++;
+        continue;
+      }
+      job->handle=handle;
+      running++;
+      started++;
+    }
+    if(!running)
+      break;
+    if((handle=wait_job(&jobfailed))<0)
+      break;
+    for(job=first_batchjob;job;job=job->next){
+      if(job->handle==handle){
+        copy_job_output(job->out,stdout,job->inname);
+        copy_job_output(job->err,stderr,job->inname);
+        job->handle=0;
+        break;
+      }
+    }
+    running--;
+    failed+=jobfailed;
+  }
+  for(job=first_batchjob;job;job=job->next){
+    if(job->handle<0)
+      general_error(97,job->inname);
+  }
+  errors=failed;
+  leave();
+}
+
+/* print the usage of all hash tables and the hot-path counters */
+static void stats_report(void)
+{
+  /* Tables with the same name (e.g. per-scope local symbols) are summed up.
+     When there are too many different names, the remaining tables are
+     summed up in an extra row. */
+  static struct {
+    const char *name;
+    unsigned long tables,size,num,used,maxchain,lookups,probes;
+  } agg[64];
+  const int maxagg=sizeof(agg)/sizeof(agg[0])-1;
+  size_t chain,maxchain,i;
+  int n,nagg=0;
+  hashentry *e;
+  hashtable *ht;
+  FILE *f=NULL;
+
+  if(stats_filename&&!(f=fopen(stats_filename,"w")))
+    general_error(13,stats_filename);
+  for(ht=first_hashtable;ht;ht=ht->next){
+    if(ht->num==0&&ht->lookups==0)
+      continue;
+    for(n=0;n<nagg;n++){
+      if(!strcmp(agg[n].name,ht->name?ht->name:"?"))
+        break;
+    }
+    if(n==nagg){
+      if(nagg==maxagg){
+        n=maxagg;  /* too many different names */
+        if(agg[n].name==NULL){
+          memset(&agg[n],0,sizeof(agg[0]));
+          agg[n].name="(other tables)";
+        }
+      }
+      else{
+        memset(&agg[nagg],0,sizeof(agg[0]));
+        agg[nagg++].name=ht->name?ht->name:"?";
+      }
+    }
+    agg[n].tables++;
+    agg[n].size+=ht->size;
+    agg[n].num+=ht->num;
+    agg[n].lookups+=ht->lookups;
+    agg[n].probes+=ht->probes;
+    for(i=maxchain=0;i<ht->size;i++){
+      for(chain=0,e=ht->entries[i];e;e=e->next)
+        chain++;
+      if(chain){
+        agg[n].used++;
+        if(chain>maxchain)
+          maxchain=chain;
+      }
+    }
+    if(maxchain>agg[n].maxchain)
+      agg[n].maxchain=maxchain;
+  }
+  if(!nostdout)
+    printf("\nhash table              size  entries     used  max chain"
+           "   lookups  probes/lookup\n");
+  if(nagg==maxagg&&agg[maxagg].name!=NULL)
+    nagg++;  /* print the extra row as well */
+  for(n=0;n<nagg;n++){
+    if(!nostdout){
+      char name[48];
+      if(agg[n].tables>1)
+        sprintf(name,"%.16s (%lu)",agg[n].name,agg[n].tables);
+      else
+        sprintf(name,"%.20s",agg[n].name);
+      printf("%-20s %7lu %8lu %8lu %10lu %9lu %14.2f\n",
+             name,agg[n].size,agg[n].num,agg[n].used,agg[n].maxchain,
+             agg[n].lookups,
+             agg[n].lookups?(double)agg[n].probes/agg[n].lookups:0.0);
+    }
+    if(f)
+      fprintf(f,"table %lu %lu %lu %lu %lu %lu %s\n",
+              agg[n].size,agg[n].num,agg[n].used,agg[n].maxchain,
+              agg[n].lookups,agg[n].probes,agg[n].name);
+  }
+  if(!nostdout)
+    printf("\ncounter                     value\n");
+  for(n=0;n<HS_NUM;n++){
+    if(!nostdout)
+      printf("%-20s %12lu\n",hot_stat_names[n],hot_stats[n]);
+    if(f)
+      fprintf(f,"counter %lu %s\n",hot_stats[n],hot_stat_names[n]);
+  }
+  if(f)
+    fclose(f);
+}
+
 /* Convert all labels from an offset-section into absolute expressions. */
 static void convert_offset_labels(void)
 {
@@ -263,16 +533,47 @@ static void vasmdebug(const char *f,section *s,atom *a)
   }
 }
 
+static struct rstats *new_rstats(section *sec)
+{
+  struct rstats *rs=mycalloc(sizeof(struct rstats));
+
+  rs->sec=sec;
+  if(last_rstats)
+    last_rstats->next=rs;
+  else
+    first_rstats=rs;
+  last_rstats=rs;
+  return rs;
+}
+
+static void rstats_pass(struct rstats *rs,unsigned long labels,
+                        unsigned long atoms,int fast)
+{
+  if(rs->passes>=rs->alloc){
+    rs->alloc=rs->alloc?rs->alloc*2:64;
+    rs->labels=myrealloc(rs->labels,rs->alloc*sizeof(unsigned long));
+    rs->atoms=myrealloc(rs->atoms,rs->alloc*sizeof(unsigned long));
+  }
+  rs->labels[rs->passes]=labels;
+  rs->atoms[rs->passes]=atoms;
+  rs->passes++;
+  if(fast)
+    rs->fastpasses++;
+}
+
 static int resolve_section(section *sec)
 {
   int fastphase=FASTOPTPHASE;
   int pass=0;
   int done,extrapass;
+  unsigned long moved,resized;
+  struct rstats *rs=resolve_stats?new_rstats(sec):NULL;
   size_t size;
   atom *p;
 
   do{
     done=1;
+    moved=resized=0;
     if (++pass>=maxpasses){
       general_error(7,sec->name);
       break;
@@ -314,6 +615,7 @@ static int resolve_section(section *sec)
                    label->name,p->line,
                    (unsigned long)label->pc,(unsigned long)sec->pc);
           done=0;
+          moved++;
           label->pc=sec->pc;
         }
       }
@@ -341,6 +643,8 @@ static int resolve_section(section *sec)
                  "%lu to %lu\n",p->type,p->line,(unsigned long)sec->pc,
                  (unsigned long)p->lastsize,(unsigned long)size);
         done=0;
+        resized++;
+        p->resizes++;
         if(pass>fastphase)
           p->changes++;  /* now count size modifications of atoms */
         else if(size>p->lastsize)
@@ -353,6 +657,8 @@ static int resolve_section(section *sec)
       sec->pc=sec->saved_pc+(sec->pc-sec->rorg_pc);
       sec->flags&=~(ABSOLUTE|IN_RORG);  /* workaround for missing RORGEND */
     }
+    if(rs)
+      rstats_pass(rs,moved,resized,pass<=fastphase);
     /* Extend the fast-optimization phase, when there was no atom which
        became larger than in the previous pass. */
     if(extrapass) fastphase++;
@@ -378,14 +684,25 @@ static void resolve(void)
   todo=mymalloc(BVSIZE(num_secs));
   memset(todo,~(bvtype)0,BVSIZE(num_secs));
   final_pass=0;
+  if(timing&&num_secs>0){
+    tm_section=mycalloc(num_secs*sizeof(double));
+    tm_passes=mycalloc(num_secs*sizeof(int));
+  }
 
   do{
     finished=1;
     for(sec=first_section;sec;sec=sec->next)
       if(BTST(todo, sec->idx)){
 	int passes;
+	double t=0.0;
 	finished=0;
+	if(timing)
+	  t=get_timer();
 	passes = resolve_section(sec);
+	if(timing&&tm_section){
+	  tm_section[sec->idx]+=get_timer()-t;
+	  tm_passes[sec->idx]+=passes;
+	}
 	BCLR(todo, sec->idx);
 	if(passes>1){
 	  if(sec->deps)
@@ -395,6 +712,73 @@ static void resolve(void)
   }while(!finished);
 }
 
+/* print the convergence of every resolved section, pass by pass, and the
+   atoms which changed their size most often */
+static void resolve_report(void)
+{
+  atom *top[RSTATS_TOPN];
+  struct rstats *rs;
+  int i,j,n=0;
+  section *sec;
+  atom *p;
+  FILE *f=NULL;
+
+  for(sec=first_section;sec;sec=sec->next){
+    for(p=sec->first;p;p=p->next){
+      if(p->resizes==0||(n==RSTATS_TOPN&&p->resizes<=top[n-1]->resizes))
+        continue;
+      for(i=n<RSTATS_TOPN?n++:n-1;i>0&&top[i-1]->resizes<p->resizes;i--)
+        top[i]=top[i-1];
+      top[i]=p;
+    }
+  }
+
+  if(rstats_filename&&!(f=fopen(rstats_filename,"w")))
+    general_error(13,rstats_filename);
+
+  for(rs=first_rstats;rs;rs=rs->next){
+    if(!nostdout){
+      printf("\nresolve section \"%s\": %d pass%s (%d fast, %d safe)\n"
+             "   pass  labels moved  atoms resized\n",
+             rs->sec->name,rs->passes,rs->passes==1?"":"es",
+             rs->fastpasses,rs->passes-rs->fastpasses);
+      for(i=0;i<rs->passes;i=j){
+        /* collapse consecutive passes with identical counts */
+        for(j=i+1;j<rs->passes&&rs->labels[j]==rs->labels[i]&&
+                  rs->atoms[j]==rs->atoms[i];j++);
+        if(j-i>1)
+          printf("%4d-%-4d",i+1,j);
+        else
+          printf("%7d  ",i+1);
+        printf("%12lu %14lu\n",rs->labels[i],rs->atoms[i]);
+      }
+    }
+    if(f){
+      /* the name may contain blanks, so it comes last */
+      fprintf(f,"section %d %d %s\n",rs->passes,rs->fastpasses,rs->sec->name);
+      for(i=0;i<rs->passes;i++)
+        fprintf(f,"pass %d %lu %lu\n",i+1,rs->labels[i],rs->atoms[i]);
+    }
+  }
+
+  if(n>0&&!nostdout)
+    printf("\natoms with most size changes:\n"
+           "changes  type  line  source\n");
+  for(i=0;i<n;i++){
+    p=top[i];
+    if(!nostdout)
+      printf("%7u  %4d  %4d  %s%s%s\n",p->resizes,p->type,p->line,
+             p->src?p->src->name:"?",p->type==INSTRUCTION?": ":"",
+             p->type==INSTRUCTION&&p->content.inst->code>=0?
+             mnemonics[p->content.inst->code].name:"");
+    if(f)
+      fprintf(f,"atom %u %d %d %s\n",p->resizes,p->type,p->line,
+              p->src?p->src->name:"?");
+  }
+  if(f)
+    fclose(f);
+}
+
 static void assemble(void)
 {
   taddr basepc;
@@ -578,10 +962,11 @@ static void fix_labels(void)
     if(add_uscore&&(sym->type==IMPORT||sym->flags&(EXPORT|COMMON|WEAK))){
       /* imported/exported symbol names receive a leading underscore */
       size_t len=strlen(sym->name)+1;
-      char *p=myrealloc(sym->name,len+1);
-      memmove(p+1,p,len);
+      char *p=mymalloc(len+1);
       p[0]='_';
-      sym->name=p;
+      memcpy(p+1,sym->name,len);
+      sym->name=intern_name(p);
+      myfree(p);
     }
 
     if((sym->flags&ABSLABEL)&&sym->type==LABSYM){
@@ -662,6 +1047,93 @@ static void statistics(void)
   }
 }
 
+/* add the time since the last mark to a phase, phase<0 just sets the mark */
+static void timing_mark(int phase)
+{
+  double now;
+
+  if(timing){
+    now=get_timer();
+    if(phase>=0)
+      tm_phase[phase]+=now-tm_last;
+    tm_last=now;
+  }
+}
+
+static void json_string(FILE *f,const char *s)
+{
+  fputc('\"',f);
+  for(;*s;s++){
+    if(*s=='\"'||*s=='\\')
+      fprintf(f,"\\%c",*s);
+    else if((unsigned char)*s<0x20)
+      fprintf(f,"\\u%04x",(unsigned char)*s);
+    else
+      fputc(*s,f);
+  }
+  fputc('\"',f);
+}
+
+static void timing_report(void)
+{
+  unsigned long natoms=0,nsyms=0;
+  double total=0.0;
+  section *sec;
+  symbol *sym;
+  atom *a;
+  FILE *f;
+  int i;
+
+  for(sec=first_section;sec;sec=sec->next)
+    for(a=sec->first;a;a=a->next)
+      natoms++;
+  for(sym=first_symbol;sym;sym=sym->next)
+    nsyms++;
+  for(i=0;i<TM_PHASES;i++)
+    total+=tm_phase[i];
+
+  if(!nostdout){
+    printf("\nphase            seconds\n");
+    for(i=0;i<TM_PHASES;i++){
+      printf("%-12s %11.6f\n",tm_names[i],tm_phase[i]);
+      if(i==TM_RESOLVE&&tm_section){
+        for(sec=first_section;sec;sec=sec->next)
+          if(sec->idx<num_secs)
+            printf("  %-10s %11.6f  %d pass%s\n",sec->name,
+                   tm_section[sec->idx],tm_passes[sec->idx],
+                   tm_passes[sec->idx]==1?"":"es");
+      }
+    }
+    printf("%-12s %11.6f\n",  "total",total);
+    printf("atoms: %lu, symbols: %lu, macro expansions: %lu, "
+           "source bytes: %lu\n",natoms,nsyms,macro_calls,
+           (unsigned long)src_bytes);
+  }
+
+  if(timing_filename){
+    if(f=fopen(timing_filename,"w")){
+      fprintf(f,"{\n  \"phases\": {");
+      for(i=0;i<TM_PHASES;i++)
+        fprintf(f,"%s\n    \"%s\": %.6f",i?",":"",tm_names[i],tm_phase[i]);
+      fprintf(f,"\n  },\n  \"total\": %.6f,\n  \"sections\": [",total);
+      for(sec=first_section,i=0;sec;sec=sec->next){
+        if(tm_section==NULL||sec->idx>=num_secs)
+          continue;
+        fprintf(f,"%s\n    { \"name\": ",i++?",":"");
+        json_string(f,sec->name);
+        fprintf(f,", \"resolve\": %.6f, \"passes\": %d }",
+                tm_section[sec->idx],tm_passes[sec->idx]);
+      }
+      fprintf(f,"\n  ],\n  \"atoms\": %lu,\n  \"symbols\": %lu,\n"
+              "  \"macro_expansions\": %lu,\n  \"source_bytes\": %lu\n}\n",
+              natoms,nsyms,macro_calls,(unsigned long)src_bytes);
+      fclose(f);
+    }
+    else
+      general_error(13,timing_filename);
+  }
+}
+
 static struct {
   const char *name;
   int executable;
@@ -711,6 +1183,7 @@ static int init_main(void)
   const char *mname;
   hashdata data;
   mnemohash=new_hashtable(MNEMOHTABSIZE);
+  mnemohash->name="mnemonics";
   i=0;
   while(i<mnemonic_cnt){
     data.idx=i;
@@ -958,6 +1431,7 @@ void set_section(section *s)
       }
     }
     current_section = s;
+    end_merged_data();
   }
 }
 
@@ -973,7 +1447,7 @@ section *new_section(const char *name,const char *attr,int align)
   p=mymalloc(sizeof(*p));
   p->next=0;
   p->deps=0;
-  p->name=mystrdup(name);
+  p->name=intern_name(name);
   p->attr=mystrdup(attr);
   p->align=align;
   p->org=p->pc=0;
@@ -1034,6 +1508,177 @@ void switch_offset_section(const char *name,taddr offs)
   set_section(sec);
 }
 
+/* Starts a new output file, which receives the sections created from
+   index first_idx on (num_secs for the next new section), until the next
+   target starts. A target starting at the same index replaces the previous
+   one. Targets with the same name are written into one file. Sections of
+   unnamed targets, and those created before the first target, are written
+   to the main output file. */
+void new_output_target(const char *name,unsigned long first_idx)
+{
+  struct output_target *t = mymalloc(sizeof(*t));
+
+  if (last_target!=NULL && first_idx<last_target->first_idx)
+    ierror(0);
+  t->next = NULL;
+  t->name = name;
+  t->first_idx = first_idx;
+  t->dest = NULL;
+  t->first_sec = t->last_sec = NULL;
+  t->first_sym = NULL;
+  if (last_target)
+    last_target = last_target->next = t;
+  else
+    first_target = last_target = t;
+}
+
+/* Starts a new output target with the following code, which gets a
+   section of its own, unless the current section is still empty. Without
+   a current section, or in a dummy section, the target starts with the
+   next new section. Returns the index of the target's first section. */
+unsigned long start_output_target(const char *name,int dummy)
+{
+  section *sec = current_section;
+  unsigned long idx;
+
+  if (sec==NULL || dummy)
+    idx = (unsigned long)num_secs;
+  else {
+    if (sec->first!=NULL || sec->idx!=(unsigned long)num_secs-1)
+      set_section(new_org(sec->pc));
+    idx = current_section->idx;
+  }
+  new_output_target(name,idx);
+  return idx;
+}
+
+static struct output_target *section_target(section *sec)
+{
+  struct output_target *t,*found = NULL;
+
+  for (t=first_target; t!=NULL && t->first_idx<=sec->idx; t=t->next)
+    found = t;
+  return found!=NULL ? found->dest : NULL;
+}
+
+/* Determines the file each target is written to. Unnamed and replaced
+   targets have none. */
+static void merge_targets(void)
+{
+  struct output_target *t,*d;
+
+  for (t=first_target; t!=NULL; t=t->next) {
+    if (t->name==NULL || (t->next!=NULL && t->next->first_idx==t->first_idx))
+      continue;
+    for (d=first_target; d!=t; d=d->next) {
+      if (d->dest==d && !filenamecmp(d->name,t->name))
+        break;
+    }
+    t->dest = d;
+  }
+}
+
+/* Moves the sections of each output file into a separate list, together
+   with the symbols defined in them. Everything else is left for the main
+   output file. Section indexes are renumbered for each list. */
+static void split_targets(void)
+{
+  struct output_target *t;
+  section *sec,*nextsec,**secp,*mainlast = NULL;
+  symbol *sym,*nextsym,*prevsym,**symp;
+  unsigned long idx;
+
+  merge_targets();
+
+  /* symbols first, as long as the section indexes are the original ones */
+  sym = first_symbol;
+  first_symbol = prevsym = NULL;
+  for (symp=&first_symbol; sym!=NULL; sym=nextsym) {
+    nextsym = sym->next;
+    if (sym->sec!=NULL && (t = section_target(sym->sec))!=NULL) {
+      sym->next = t->first_sym;  /* reversed, restored below */
+      t->first_sym = sym;
+    }
+    else {
+      *symp = sym;
+      symp = &sym->next;
+      sym->prev = prevsym;
+      prevsym = sym;
+    }
+  }
+  *symp = NULL;
+
+  sec = first_section;
+  first_section = NULL;
+  for (secp=&first_section,idx=0; sec!=NULL; sec=nextsec) {
+    nextsec = sec->next;
+    sec->next = NULL;
+    if ((t = section_target(sec)) != NULL) {
+      if (t->last_sec)
+        t->last_sec = t->last_sec->next = sec;
+      else
+        t->first_sec = t->last_sec = sec;
+    }
+    else {
+      *secp = mainlast = sec;
+      secp = &sec->next;
+      sec->idx = idx++;
+    }
+  }
+  last_section = mainlast;
+  num_secs = (int)idx;
+
+  for (t=first_target; t!=NULL; t=t->next) {
+    for (sec=t->first_sec,idx=0; sec!=NULL; sec=sec->next)
+      sec->idx = idx++;
+    /* restore original symbol order */
+    for (sym=t->first_sym,t->first_sym=NULL; sym!=NULL; sym=nextsym) {
+      nextsym = sym->next;
+      sym->next = t->first_sym;
+      if (t->first_sym)
+        t->first_sym->prev = sym;
+      sym->prev = NULL;
+      t->first_sym = sym;
+    }
+  }
+}
+
+/* check whether the main output file receives any code or data */
+static int main_output_needed(void)
+{
+  section *sec;
+
+  if (first_target == NULL)
+    return 1;
+  for (sec=first_section; sec!=NULL; sec=sec->next) {
+    if (get_sec_size(sec) != 0)
+      return 1;
+  }
+  return 0;
+}
+
+static void write_targets(void)
+{
+  struct output_target *t;
+  section *sec;
+  FILE *f;
+
+  for (t=first_target; t!=NULL; t=t->next) {
+    if (t->dest != t)
+      continue;  /* unnamed, replaced or merged */
+    if (!(f = fopen(t->name,asciiout?"w":"wb"))) {
+      general_error(13,t->name);
+      continue;
+    }
+    for (num_secs=0,sec=t->first_sec; sec!=NULL; sec=sec->next)
+      num_secs++;
+    write_object(f,t->first_sec,t->first_sym);
+    fclose(f);
+    if (errors)
+      remove(t->name);
+  }
+}
+
 /* returns current_section or the syntax module's default section,
    when undefined */
 section *default_section(void)
@@ -1202,6 +1847,94 @@ static void set_defaults(void)
     set_syntax_default();
 }
 
+#ifdef VASM_FUZZ
+/* inline 8-bit coverage counters of all modules, from -fsanitize=fuzzer */
+extern uint8_t __start___sancov_cntrs[] __attribute__((weak));
+extern uint8_t __stop___sancov_cntrs[] __attribute__((weak));
+
+/* libFuzzer entry point (make fuzz). Every input is parsed, resolved and
+   assembled as a main source, but no output is written. The modules are
+   initialized once, then each input is assembled in a child process, so
+   it starts from the same state and a finding can be reproduced with this
+   input alone. The child's coverage counters are passed back to the
+   fuzzer through shared memory. A crash or sanitizer error in the child
+   aborts the fuzzer, which then saves the input. */
+int LLVMFuzzerTestOneInput(const unsigned char *data,size_t size)
+{
+  static uint8_t *counters;
+  static size_t ncounters;
+  static int initialized;
+  char *text;
+  pid_t pid;
+  int status;
+  size_t i;
+
+  if(!initialized){
+    if(!init_output("bin")||!init_main()||!init_symbol()||
+       !init_osdep()||!init_listing())
+      ierror(0);
+    internal_abs(vasmsym_name);
+    if(!init_parse()||!init_syntax()||!init_cpu())
+      ierror(0);
+    set_taddr();
+    set_defaults();
+    if(!init_expr())
+      ierror(0);
+    max_errors=0;
+    nostdout=1;
+    if(__start___sancov_cntrs!=NULL&&__stop___sancov_cntrs!=NULL){
+      ncounters=__stop___sancov_cntrs-__start___sancov_cntrs;
+      counters=mmap(NULL,ncounters,PROT_READ|PROT_WRITE,
+                    MAP_SHARED|MAP_ANONYMOUS,-1,0);
+      if(counters==MAP_FAILED)
+        ierror(0);
+    }
+    initialized=1;
+  }
+
+  fflush(NULL);
+  if((pid=fork())<0){
+    perror("fork");
+    abort();
+  }
+  if(pid==0){
+    text=mymalloc(size+1);
+    memcpy(text,data,size);
+    text[size]='\n';
+    if(!setjmp(fuzz_env)){
+      fuzzing=1;
+      memory_source("fuzz",text,size+1);
+      parse();
+      cleanup_parse();
+      if(errors==0)
+        resolve();
+      if(errors==0)
+        assemble();
+      if(errors==0){
+        fix_labels();
+        undef_syms();
+      }
+    }
+    if(ncounters)
+      memcpy(counters,__start___sancov_cntrs,ncounters);
+    _exit(0);  /* without leak checks, memory is never freed */
+  }
+
+  while(waitpid(pid,&status,0)<0){
+    if(errno!=EINTR){
+      perror("waitpid");
+      abort();
+    }
+  }
+  if(!WIFEXITED(status)||WEXITSTATUS(status)!=0)
+    abort();  /* crashed, or a sanitizer reported an error */
+  for(i=0;i<ncounters;i++){
+    if(counters[i]>__start___sancov_cntrs[i])
+      __start___sancov_cntrs[i]=counters[i];
+  }
+  return 0;
+}
+#else
 int main(int argc,char **argv)
 {
   static strbuf buf;
@@ -1219,6 +1952,10 @@ int main(int argc,char **argv)
       debug=1;
       argv[i][0]=0;
     }
+    if(!strcmp("-batch",argv[i])){
+      batch_mode=1;  /* before the input names are parsed */
+      argv[i][0]=0;
+    }
     if(!strcmp("-v",argv[i]))
       verbose=2;
   }
@@ -1245,9 +1982,12 @@ int main(int argc,char **argv)
     if(argv[i][0]==0)
       continue;
     if(argv[i][0]!='-'){
-      if(inname)
+      if(batch_mode)
+        new_batchjob(argv[i]);
+      else if(inname)
         general_error(11);
-      inname=argv[i];
+      else
+        inname=argv[i];
       continue;
     }
     if(!strcmp("-o",argv[i])&&i<argc-1){
@@ -1345,6 +2085,37 @@ int main(int argc,char **argv)
       sscanf(argv[i]+14,"%i",&maxmacrecurs);
       continue;
     }
+    if(!strncmp("-timing",argv[i],7)&&(argv[i][7]=='\0'||argv[i][7]=='=')){
+      timing=1;
+      if(argv[i][7]=='=')
+        timing_filename=&argv[i][8];
+      continue;
+    }
+    if(!strncmp("-resolve-stats",argv[i],14)&&
+       (argv[i][14]=='\0'||argv[i][14]=='=')){
+      resolve_stats=1;
+      if(argv[i][14]=='=')
+        rstats_filename=&argv[i][15];
+      continue;
+    }
+    if(!strncmp("-stats",argv[i],6)&&(argv[i][6]=='\0'||argv[i][6]=='=')){
+      hot_stats_report=1;
+      if(argv[i][6]=='=')
+        stats_filename=&argv[i][7];
+      continue;
+    }
+    if(!strncmp("-jobs=",argv[i],6)){
+      sscanf(argv[i]+6,"%i",&batch_jobs);
+      continue;
+    }
+    if(!strncmp("-pch-in=",argv[i],8)){
+      pch_inname=&argv[i][8];
+      continue;
+    }
+    if(!strncmp("-pch-out=",argv[i],9)){
+      pch_outname=&argv[i][9];
+      continue;
+    }
     if(!strncmp("-maxpasses=",argv[i],11)){
       sscanf(argv[i]+11,"%i",&maxpasses);
       continue;
@@ -1466,9 +2237,32 @@ int main(int argc,char **argv)
     dwarf=0;  /* no DWARF output when input source is from stdin */
     general_error(84);
   }
+  if(batch_mode){
+    if(outname)
+      general_error(89,"-o");
+    if(produce_listing)
+      general_error(89,"-L");
+    if(dep_filename)
+      general_error(89,"-depfile");
+    if(symbols_filename)
+      general_error(89,"-symbols");
+    if(pch_outname)
+      general_error(89,"-pch-out");
+    if(timing_filename)
+      general_error(89,"-timing=");  /* every worker would write the file */
+    if(rstats_filename)
+      general_error(89,"-resolve-stats=");
+    if(stats_filename)
+      general_error(89,"-stats=");
+  }
+  else if(pch_outname&&inname==NULL)
+    general_error(92,"-pch-out");
+  if(pch_inname||pch_outname)
+    pch_options(argc,argv);
   if(errors) leave();
   nostdout=depend&&dep_filename==NULL; /* dependencies to stdout nothing else */
-  include_main_source();
+  if(!batch_mode)
+    include_main_source();
   internal_abs(vasmsym_name);
   if(!init_parse())
     general_error(10,"parse");
@@ -1480,11 +2274,22 @@ int main(int argc,char **argv)
   set_defaults();
   if(!init_expr())
     general_error(10,"expr");
+  if(pch_inname)
+    read_pch(pch_inname);
+  if(batch_mode){
+    run_batch();  /* returns in a worker process */
+    include_main_source();
+  }
+  timing_mark(-1);
   parse();
   cleanup_parse();
+  timing_mark(TM_PARSE);
   listena=0;
   if(errors==0||produce_listing)
     resolve();
+  timing_mark(TM_RESOLVE);
+  if(resolve_stats)
+    resolve_report();
   if(errors==0||produce_listing)
     assemble();
   cur_src=NULL;
@@ -1492,19 +2297,23 @@ int main(int argc,char **argv)
     fix_labels();
     undef_syms();
   }
+  timing_mark(TM_ASSEMBLE);
   if(produce_listing){
     if(!listname)
       listname="a.lst";
     write_listing(listname,first_section);
+    timing_mark(TM_LISTING);
   }
   if(symbols_filename&&errors==0){
     write_symbols_edtasm(symbols_filename);
+    timing_mark(TM_SYMBOLS);
   }
   remove_unalloc_sects();
   if(errors==0){
     if(depend&&dep_filename==NULL){
       /* dependencies to stdout, no object output */
       write_depends(stdout);
+      timing_mark(TM_DEPEND);
     } else {
       trim_uninitialized(first_section);
       if(verbose)
@@ -1518,17 +2327,37 @@ int main(int argc,char **argv)
         }
         else
           general_error(13,dep_filename);
+        timing_mark(TM_DEPEND);
       }
-      /* write the object file */
-      if(!outname)
-        outname="a.out";
-      outfile=fopen(outname,asciiout?"w":"wb");
-      if(!outfile)
-        general_error(13,outname);
-      else
-        write_object(outfile,first_section,first_symbol);
+      if(pch_outname){
+        /* headers only: write their definitions instead of an object */
+        write_pch(pch_outname,first_section,first_symbol);
+      }
+      else{
+        /* write the object file, and the output targets */
+        if(first_target)
+          split_targets();
+        if(main_output_needed()){
+          if(!outname)
+            outname="a.out";
+          outfile=fopen(outname,asciiout?"w":"wb");
+          if(!outfile)
+            general_error(13,outname);
+          else{
+            write_object(outfile,first_section,first_symbol);
+            fflush(outfile);
+          }
+        }
+        write_targets();
+      }
+      timing_mark(TM_OUTPUT);
     }
   }
+  if(timing)
+    timing_report();
+  if(hot_stats_report)
+    stats_report();
   leave();
   return 0; /* not reached */
 }
+#endif
@@ -79,6 +79,10 @@ typedef struct strbuf {
 #define CHKIDEND(s,e) (e)
 #endif
 
+#ifndef REPLICATE_OPERANDS
+#define REPLICATE_OPERANDS 0
+#endif
+
 #define MAXPATHLEN 1024
 
 /* operations on bit-vectors */
@@ -105,7 +109,7 @@ typedef unsigned int bvtype;
 struct section {
   struct section *next;
   bvtype *deps;
-  char *name;
+  const char *name;
   char *attr;
   atom *first;
   atom *last;
@@ -145,7 +149,7 @@ extern int chklabels,nocase,no_symbols,pic_check,unnamed_sections;
 extern unsigned space_init;
 extern int asciiout,secname_attr,warn_unalloc_ini_dat;
 extern hashtable *mnemohash;
-extern char *filename,*debug_filename;
+extern const char *filename,*debug_filename;
 extern source *cur_src;
 extern section *current_section,container_section;
 extern int num_secs,final_pass,exec_out,nostdout;
@@ -169,6 +173,8 @@ void join_sections(section *,symbol *,utaddr);
 void set_section(section *);
 section *new_section(const char *,const char *,int);
 section *new_org(taddr);
+void new_output_target(const char *,unsigned long);
+unsigned long start_output_target(const char *,int);
 section *find_section(const char *,const char *);
 void switch_offset_section(const char *,taddr);
 void add_align(section *,taddr,expr *,int,unsigned char *);
@@ -266,6 +272,11 @@ void eol(char *);
 char *const_prefix(char *,int *);
 char *const_suffix(char *,char *);
 strbuf *get_local_label(int,char **);
+#ifdef SYNTAX_PCH_STATE
+void save_syntax_state(void (*)(const char *,const char *,const char *,
+                                uint32_t,void *),void *);
+void load_syntax_state(const char *,const char *,const char *,uint32_t);
+#endif
 
 /* provided by output_xxx.c */
 #ifdef OUTTOS
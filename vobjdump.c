@@ -83,8 +83,9 @@ static const char *type_name[] = {
   "","obj","func","sect","file",NULL
 };
 
+static int show;      /* SHOW_xxx flags */
 static int ver;       /* VOBJ version */
-static ubyte *vobj;   /* base address of VOBJ buffer */
+static ubyte *vobj;   /* base address of mapped or buffered VOBJ file */
 static size_t vlen;   /* length of VOBJ file in buffer */
 static ubyte *p;      /* current object pointer */
 static int bpb,bpt;   /* bits per target-byte, target-bytes per taddr */
@@ -247,6 +248,7 @@ static void read_section(struct vobj_section *vsect,
 {
   const char *attr;
   unsigned long flags;
+  taddr addr = 0;
   int align,nrelocs,i;
 
   vsect->offs = p - vobj;
@@ -256,37 +258,45 @@ static void read_section(struct vobj_section *vsect,
   skip_string();
   flags = (unsigned long)read_number(0);
 
-  print_sep();
-  printf("%08llx: SECTION \"%s\" (attributes=\"%s\")",
-         BPTMASK(vsect->offs),vsect->name,attr);
   if (ver>=3 && (flags&ABSOLUTE))
-    printf(" @%llx\n",BPTMASK(read_number(0)));
-  else
-    putchar('\n');
-
+    addr = read_number(0);
   align = (int)read_number(0);
   vsect->dsize = read_number(0);
   nrelocs = (int)read_number(0);
   vsect->fsize = read_number(0);
 
-  printf("Flags: %-8lx  Alignment: %-6d "
-         "Total size: %-9" PRId64 " File size: %-9" PRId64 "\n",
-         flags,align,vsect->dsize,vsect->fsize);
-  if (nrelocs)
-    printf("%d Relocation%s present.\n",nrelocs,nrelocs==1?emptystr:sstr);
+  if (show & (SHOW_SECTIONS|SHOW_RELOCS)) {
+    print_sep();
+    printf("%08llx: SECTION \"%s\" (attributes=\"%s\")",
+           BPTMASK(vsect->offs),vsect->name,attr);
+    if (ver>=3 && (flags&ABSOLUTE))
+      printf(" @%llx\n",BPTMASK(addr));
+    else
+      putchar('\n');
+    printf("Flags: %-8lx  Alignment: %-6d "
+           "Total size: %-9" PRId64 " File size: %-9" PRId64 "\n",
+           flags,align,vsect->dsize,vsect->fsize);
+    if (nrelocs)
+      printf("%d Relocation%s present.\n",nrelocs,nrelocs==1?emptystr:sstr);
+  }
 
-  p += vsect->fsize * opb;  /* skip section contents */
+  /* skip section contents, which are never touched in a mapped file */
+  if (vsect->fsize<0 || vsect->fsize*opb > (size_t)(vobj+vlen-p))
+    obj_corrupt();
+  p += vsect->fsize * opb;
 
   /* read and print relocations for this section */
   for (i=0; i<nrelocs; i++) {
     int type;
     size_t len;
 
-    if (i == 0) {
-      /* print header */
-      printf("\nfile offs sectoffs pos sz mask     type     symbol+addend\n");
+    if (show & SHOW_RELOCS) {
+      if (i == 0) {
+        /* print header */
+        printf("\nfile offs sectoffs pos sz mask     type     symbol+addend\n");
+      }
+      printf("%08llx: ",BPTMASK(p-vobj));
     }
-    printf("%08llx: ",BPTMASK(p-vobj));
 
     type = read_number(0);
     if (type >= FIRST_CPU_RELOC)
@@ -309,13 +319,14 @@ static void read_section(struct vobj_section *vsect,
       mask = read_number(1);
       addend = read_number(1);
       sym = (int)read_number(0) - 1;  /* symbol index */
-      print_nreloc(type >= FIRST_CPU_RELOC ?
-                   cpu_reloc_name(type) : standard_reloc_name(type),
-                   vsect,vsym,nsyms,offs,bpos,bsiz,mask,addend,sym);
+      if (show & SHOW_RELOCS)
+        print_nreloc(type >= FIRST_CPU_RELOC ?
+                     cpu_reloc_name(type) : standard_reloc_name(type),
+                     vsect,vsym,nsyms,offs,bpos,bsiz,mask,addend,sym);
     }
     else {
       /* special relocation in cpu-specific format */
-      if (!print_cpureloc(type,p)) {
+      if ((show & SHOW_RELOCS) && !print_cpureloc(type,p)) {
         char sname[32];
 
         sprintf(sname,"%.10s special reloc",cpu_name);
@@ -440,11 +451,12 @@ static int vobjdump(void)
     }
 
     /* print symbols */
-    for (i=0; i<nsyms; i++) {
+    for (i=0; i<nsyms && (show & SHOW_SYMBOLS); i++) {
       struct vobj_symbol *vs = &vsymbols[i];
 
       if (i == 0) {
-        printf("\n");
+        if (show != SHOW_SYMBOLS)
+          printf("\n");
         print_sep();
         printf("SYMBOL TABLE\n"
                "file offs bind size     type def      value    name\n");
@@ -473,6 +485,41 @@ static int vobjdump(void)
 }
 
 
+#ifdef UNIX
+
+static int load_file(const char *name)
+/* map the file into memory, its pages are only read when accessed */
+{
+  struct stat st;
+  int fd;
+
+  if ((fd = open(name,O_RDONLY)) < 0) {
+    fprintf(stderr,"Cannot open \"%s\" for reading!\n",name);
+    return 0;
+  }
+  if (fstat(fd,&st)<0 || st.st_size<=0) {
+    fprintf(stderr,"Cannot determine size of file \"%s\"!\n",name);
+    close(fd);
+    return 0;
+  }
+  vlen = (size_t)st.st_size;
+  vobj = mmap(NULL,vlen,PROT_READ,MAP_PRIVATE,fd,0);
+  close(fd);
+  if (vobj == MAP_FAILED) {
+    fprintf(stderr,"Cannot map file \"%s\"!\n",name);
+    return 0;
+  }
+  return 1;
+}
+
+
+static void unload_file(void)
+{
+  munmap(vobj,vlen);
+}
+
+#else
+
 static size_t filesize(FILE *fp,const char *name)
 {
   long size;
@@ -487,34 +534,75 @@ static size_t filesize(FILE *fp,const char *name)
 }
 
 
+static int load_file(const char *name)
+/* read the whole file into a buffer */
+{
+  int ok = 0;
+  FILE *f;
+
+  if (f = fopen(name,"rb")) {
+    if (vlen = filesize(f,name)) {
+      if (vobj = malloc(vlen)) {
+        if (fread(vobj,1,vlen,f) == vlen)
+          ok = 1;
+        else {
+          fprintf(stderr,"Read error on \"%s\"!\n",name);
+          free(vobj);
+        }
+      }
+      else
+        fprintf(stderr,"Unable to allocate %lu bytes "
+                "to buffer file \"%s\"!\n",(unsigned long)vlen,name);
+    }
+    fclose(f);
+  }
+  else
+    fprintf(stderr,"Cannot open \"%s\" for reading!\n",name);
+  return ok;
+}
+
+
+static void unload_file(void)
+{
+  free(vobj);
+}
+
+#endif
+
+
 int main(int argc,char *argv[])
 {
+  const char *name = NULL;
   int rc = 1;
+  int i;
 
-  if (argc == 2) {
-    FILE *f;
+  for (i=1; i<argc; i++) {
+    if (!strcmp(argv[i],"-sections"))
+      show |= SHOW_SECTIONS;
+    else if (!strcmp(argv[i],"-relocs"))
+      show |= SHOW_RELOCS;
+    else if (!strcmp(argv[i],"-symbols"))
+      show |= SHOW_SYMBOLS;
+    else if (argv[i][0]!='-' && name==NULL)
+      name = argv[i];
+    else {
+      name = NULL;
+      break;
+    }
+  }
+  if (show == 0)
+    show = SHOW_ALL;
 
-    if (f = fopen(argv[1],"rb")) {
-      if (vlen = filesize(f,argv[1])) {
-        if (vobj = malloc(vlen)) {
-          if (fread(vobj,1,vlen,f) == vlen)
-            rc = vobjdump();
-          else
-            fprintf(stderr,"Read error on \"%s\"!\n",argv[1]);
-          free(vobj);
-        }
-        else
-          fprintf(stderr,"Unable to allocate %lu bytes "
-                  "to buffer file \"%s\"!\n",vlen,argv[1]);
-      }
-      fclose(f);
-    }    
-    else
-      fprintf(stderr,"Cannot open \"%s\" for reading!\n",argv[1]);
+  if (name != NULL) {
+    if (load_file(name)) {
+      rc = vobjdump();
+      unload_file();
+    }
   }
   else
-    fprintf(stderr,"vobjdump V0.8\nWritten by Frank Wille\n"
-            "Usage: %s <file name>\n",argv[0]);
+    fprintf(stderr,"vobjdump V0.9\nWritten by Frank Wille\n"
+            "Usage: %s [-sections] [-relocs] [-symbols] <file name>\n",
+            argv[0]);
 
   return rc;
 }
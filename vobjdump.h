@@ -4,12 +4,22 @@
  * Written by Frank Wille <frank@phoenix.owl.de>.
  */
 
+#if defined(UNIX) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L  /* mmap() */
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
 #include <inttypes.h>
 #include <limits.h>
+#ifdef UNIX
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 /* maximum VOBJ version to support */
 #define VOBJ_MAX_VERSION 3
@@ -56,4 +66,10 @@ struct vobj_section {
 #define REL_MOD_S 0x20
 #define REL_MOD_U 0x40
 #define FIRST_CPU_RELOC 0x80
+/* parts of the object to print */
+#define SHOW_SECTIONS 1
+#define SHOW_RELOCS   2
+#define SHOW_SYMBOLS  4
+#define SHOW_ALL      (SHOW_SECTIONS|SHOW_RELOCS|SHOW_SYMBOLS)
+
 #define makemask(x) (((x)>=sizeof(unsigned long long)*CHAR_BIT)?(~(unsigned long long)0):((((unsigned long long)1)<<(x))-1u))